@@ -0,0 +1,775 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  Asynchronous File I/O
+//
+//  Implements AsyncIO using either io_uring or a pool of worker threads.
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "AsyncIO.h"
+
+#include <algorithm>
+#include <climits>
+#include <condition_variable>
+#include <deque>
+#include <errno.h>
+#include <fcntl.h>
+#include <mutex>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <thread>
+
+#ifdef _WIN32
+	#include <io.h>
+	#include <malloc.h>
+	#include <windows.h>
+#else
+	#include <unistd.h>
+#endif
+
+//io_uring is used where the kernel headers provide it, and is detected at runtime
+#if defined(__linux__) && defined(__has_include)
+	#if __has_include(<linux/io_uring.h>)
+		#include <linux/io_uring.h>
+		#include <sys/mman.h>
+		#include <sys/syscall.h>
+		#include <sys/uio.h>
+		#ifdef __NR_io_uring_setup
+			#define USE_IO_URING
+		#endif
+	#endif
+#endif
+
+//Buffers in the pool are aligned to (and sized in multiples of) the page size, as required for O_DIRECT
+#define ASYNC_BUFFER_ALIGNMENT 4096
+
+//The largest number of bytes transferred by a single read or write under Linux
+#define ASYNC_MAX_TRANSFER 0x7FFFF000
+
+//The maximum number of threads used by the thread pool backend
+#define ASYNC_MAX_THREADS 64
+
+enum AsyncOperationType
+{
+	ASYNC_READ,
+	ASYNC_WRITE,
+	ASYNC_READ_FIXED,
+	ASYNC_WRITE_FIXED,
+	ASYNC_OPEN,
+	ASYNC_CLOSE,
+	ASYNC_STAT
+};
+
+struct AsyncOperation
+{
+	int type;
+	int fd;
+	char* buffer;
+	size_t length;
+	int64_t offset;
+	int bufferIndex;
+	string path;
+	int flags;
+	int mode;
+	FileInfo* info;
+	int64_t result;
+	AsyncIO::Callback callback;
+	
+	#if defined(USE_IO_URING) && defined(STATX_BASIC_STATS)
+	struct statx extendedInfo;
+	#endif
+};
+
+class AsyncEngine
+{
+	public:
+		virtual ~AsyncEngine() {}
+		
+		//Adds an operation to the batch that will be started by the next call to submit()
+		virtual void queue(AsyncOperation* operation) = 0;
+		
+		//Starts all queued operations, returning the number started
+		virtual unsigned int submit() = 0;
+		
+		//Waits until at least minCompletions operations have completed, appending them to the supplied list
+		virtual void reap(unsigned int minCompletions, vector<AsyncOperation*>& completed) = 0;
+};
+
+namespace
+{
+	int64_t read_at(int fd, char* buffer, size_t length, int64_t offset)
+	{
+		#ifdef _WIN32
+		
+		if (offset < 0)
+		{
+			int result = _read(fd, buffer, (unsigned int)std::min(length, (size_t)INT_MAX));
+			return (result == -1) ? -errno : result;
+		}
+		
+		OVERLAPPED overlapped;
+		memset(&overlapped, 0, sizeof(overlapped));
+		overlapped.Offset     = (DWORD)offset;
+		overlapped.OffsetHigh = (DWORD)(offset >> 32);
+		
+		DWORD transferred = 0;
+		if (!ReadFile((HANDLE)_get_osfhandle(fd), buffer, (DWORD)std::min(length, (size_t)MAXDWORD), &transferred, &overlapped)) {
+			return (GetLastError() == ERROR_HANDLE_EOF) ? 0 : -EIO;
+		}
+		
+		return transferred;
+		
+		#else
+		ssize_t result = (offset < 0) ? ::read(fd, buffer, length) : pread(fd, buffer, length, offset);
+		return (result == -1) ? -errno : result;
+		#endif
+	}
+	
+	int64_t write_at(int fd, const char* buffer, size_t length, int64_t offset)
+	{
+		#ifdef _WIN32
+		
+		if (offset < 0)
+		{
+			int result = _write(fd, buffer, (unsigned int)std::min(length, (size_t)INT_MAX));
+			return (result == -1) ? -errno : result;
+		}
+		
+		OVERLAPPED overlapped;
+		memset(&overlapped, 0, sizeof(overlapped));
+		overlapped.Offset     = (DWORD)offset;
+		overlapped.OffsetHigh = (DWORD)(offset >> 32);
+		
+		DWORD transferred = 0;
+		if (!WriteFile((HANDLE)_get_osfhandle(fd), buffer, (DWORD)std::min(length, (size_t)MAXDWORD), &transferred, &overlapped)) {
+			return -EIO;
+		}
+		
+		return transferred;
+		
+		#else
+		ssize_t result = (offset < 0) ? ::write(fd, buffer, length) : pwrite(fd, buffer, length, offset);
+		return (result == -1) ? -errno : result;
+		#endif
+	}
+	
+	//Performs an operation using the regular blocking calls
+	int64_t perform_operation(AsyncOperation* operation)
+	{
+		switch (operation->type)
+		{
+			case ASYNC_READ:
+			case ASYNC_READ_FIXED:
+				return read_at(operation->fd, operation->buffer, operation->length, operation->offset);
+			
+			case ASYNC_WRITE:
+			case ASYNC_WRITE_FIXED:
+				return write_at(operation->fd, operation->buffer, operation->length, operation->offset);
+			
+			case ASYNC_OPEN:
+			{
+				int fd = ::open(operation->path.c_str(), operation->flags, operation->mode);
+				return (fd == -1) ? -errno : fd;
+			}
+			
+			case ASYNC_CLOSE:
+				return (::close(operation->fd) == -1) ? -errno : 0;
+			
+			case ASYNC_STAT:
+			{
+				errno = 0;
+				*operation->info = file_info(operation->path);
+				return (operation->info->exists) ? 0 : ((errno != 0) ? -errno : -ENOENT);
+			}
+		}
+		
+		return -EINVAL;
+	}
+	
+	class ThreadPoolEngine : public AsyncEngine
+	{
+		public:
+			ThreadPoolEngine(unsigned int threads)
+			{
+				this->stopping = false;
+				for (unsigned int i = 0; i < threads; ++i) {
+					this->workers.push_back(std::thread(&ThreadPoolEngine::work, this));
+				}
+			}
+			
+			~ThreadPoolEngine()
+			{
+				{
+					std::lock_guard<std::mutex> lock(this->pendingMutex);
+					this->stopping = true;
+				}
+				
+				this->pendingCondition.notify_all();
+				for (vector<std::thread>::iterator worker = this->workers.begin(); worker != this->workers.end(); ++worker) {
+					worker->join();
+				}
+			}
+			
+			void queue(AsyncOperation* operation) {
+				this->batch.push_back(operation);
+			}
+			
+			unsigned int submit()
+			{
+				unsigned int count = (unsigned int)this->batch.size();
+				if (count == 0) {
+					return 0;
+				}
+				
+				{
+					std::lock_guard<std::mutex> lock(this->pendingMutex);
+					this->pending.insert(this->pending.end(), this->batch.begin(), this->batch.end());
+				}
+				
+				this->batch.clear();
+				if (count == 1) {
+					this->pendingCondition.notify_one();
+				}
+				else {
+					this->pendingCondition.notify_all();
+				}
+				
+				return count;
+			}
+			
+			void reap(unsigned int minCompletions, vector<AsyncOperation*>& completed)
+			{
+				std::unique_lock<std::mutex> lock(this->finishedMutex);
+				this->finishedCondition.wait(lock, [this, minCompletions]() { return this->finished.size() >= minCompletions; });
+				completed.insert(completed.end(), this->finished.begin(), this->finished.end());
+				this->finished.clear();
+			}
+		
+		private:
+			void work()
+			{
+				std::unique_lock<std::mutex> lock(this->pendingMutex);
+				while (true)
+				{
+					this->pendingCondition.wait(lock, [this]() { return this->stopping || !this->pending.empty(); });
+					if (this->pending.empty()) {
+						return;
+					}
+					
+					AsyncOperation* operation = this->pending.front();
+					this->pending.pop_front();
+					lock.unlock();
+					
+					operation->result = perform_operation(operation);
+					
+					{
+						std::lock_guard<std::mutex> finishedLock(this->finishedMutex);
+						this->finished.push_back(operation);
+					}
+					
+					this->finishedCondition.notify_one();
+					lock.lock();
+				}
+			}
+			
+			vector<AsyncOperation*> batch;
+			
+			std::mutex pendingMutex;
+			std::condition_variable pendingCondition;
+			std::deque<AsyncOperation*> pending;
+			bool stopping;
+			
+			std::mutex finishedMutex;
+			std::condition_variable finishedCondition;
+			vector<AsyncOperation*> finished;
+			
+			vector<std::thread> workers;
+	};
+	
+	#ifdef USE_IO_URING
+	class IoUringEngine : public AsyncEngine
+	{
+		public:
+			IoUringEngine()
+			{
+				this->ringFd       = -1;
+				this->sqRing       = MAP_FAILED;
+				this->cqRing       = MAP_FAILED;
+				this->sqes         = (io_uring_sqe*)MAP_FAILED;
+				this->sqRingSize   = 0;
+				this->cqRingSize   = 0;
+				this->sqesSize     = 0;
+				this->localTail    = 0;
+				this->fixedBuffers = false;
+			}
+			
+			~IoUringEngine()
+			{
+				if (this->sqes != MAP_FAILED) {
+					munmap(this->sqes, this->sqesSize);
+				}
+				
+				if (this->cqRing != MAP_FAILED && this->cqRing != this->sqRing) {
+					munmap(this->cqRing, this->cqRingSize);
+				}
+				
+				if (this->sqRing != MAP_FAILED) {
+					munmap(this->sqRing, this->sqRingSize);
+				}
+				
+				if (this->ringFd != -1) {
+					::close(this->ringFd);
+				}
+			}
+			
+			//Creates the ring and registers the buffer pool, returning false if io_uring is unavailable
+			bool initialise(unsigned int entries, char* buffers, unsigned int bufferCount, size_t bufferSize)
+			{
+				io_uring_params params;
+				memset(&params, 0, sizeof(params));
+				this->ringFd = (int)syscall(__NR_io_uring_setup, entries, &params);
+				if (this->ringFd == -1) {
+					return false;
+				}
+				
+				//Operations on paths and on the current file offset require Linux 5.6, which also introduced this feature flag
+				if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+					return false;
+				}
+				
+				//Map the submission and completion rings (which share a single mapping under Linux 5.4 and newer)
+				this->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+				this->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+				if (params.features & IORING_FEAT_SINGLE_MMAP) {
+					this->sqRingSize = this->cqRingSize = std::max(this->sqRingSize, this->cqRingSize);
+				}
+				
+				this->sqRing = mmap(NULL, this->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->ringFd, IORING_OFF_SQ_RING);
+				if (this->sqRing == MAP_FAILED) {
+					return false;
+				}
+				
+				if (params.features & IORING_FEAT_SINGLE_MMAP) {
+					this->cqRing = this->sqRing;
+				}
+				else
+				{
+					this->cqRing = mmap(NULL, this->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->ringFd, IORING_OFF_CQ_RING);
+					if (this->cqRing == MAP_FAILED) {
+						return false;
+					}
+				}
+				
+				this->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+				this->sqes = (io_uring_sqe*)mmap(NULL, this->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->ringFd, IORING_OFF_SQES);
+				if (this->sqes == MAP_FAILED) {
+					return false;
+				}
+				
+				char* sq = (char*)this->sqRing;
+				this->sqHead  = (unsigned int*)(sq + params.sq_off.head);
+				this->sqTail  = (unsigned int*)(sq + params.sq_off.tail);
+				this->sqMask  = *(unsigned int*)(sq + params.sq_off.ring_mask);
+				this->sqArray = (unsigned int*)(sq + params.sq_off.array);
+				this->localTail = *this->sqTail;
+				
+				char* cq = (char*)this->cqRing;
+				this->cqHead = (unsigned int*)(cq + params.cq_off.head);
+				this->cqTail = (unsigned int*)(cq + params.cq_off.tail);
+				this->cqMask = *(unsigned int*)(cq + params.cq_off.ring_mask);
+				this->cqes   = (io_uring_cqe*)(cq + params.cq_off.cqes);
+				
+				//Registering the buffers can fail if they exceed the locked memory limit, in which case the fixed
+				//operations are performed as regular reads and writes using the same buffers
+				if (bufferCount > 0)
+				{
+					vector<iovec> vectors(bufferCount);
+					for (unsigned int i = 0; i < bufferCount; ++i)
+					{
+						vectors[i].iov_base = buffers + (i * bufferSize);
+						vectors[i].iov_len  = bufferSize;
+					}
+					
+					this->fixedBuffers = (syscall(__NR_io_uring_register, this->ringFd, IORING_REGISTER_BUFFERS, vectors.data(), bufferCount) == 0);
+				}
+				
+				return true;
+			}
+			
+			void queue(AsyncOperation* operation)
+			{
+				//The number of operations in flight never exceeds the number of entries, so a submission entry is always free
+				unsigned int index = this->localTail & this->sqMask;
+				io_uring_sqe* sqe = &this->sqes[index];
+				memset(sqe, 0, sizeof(io_uring_sqe));
+				sqe->user_data = (uint64_t)(uintptr_t)operation;
+				
+				switch (operation->type)
+				{
+					case ASYNC_READ:
+					case ASYNC_WRITE:
+					case ASYNC_READ_FIXED:
+					case ASYNC_WRITE_FIXED:
+					{
+						bool isRead  = (operation->type == ASYNC_READ || operation->type == ASYNC_READ_FIXED);
+						bool isFixed = (operation->type == ASYNC_READ_FIXED || operation->type == ASYNC_WRITE_FIXED) && this->fixedBuffers;
+						
+						if (isFixed)
+						{
+							sqe->opcode    = (isRead) ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+							sqe->buf_index = operation->bufferIndex;
+						}
+						else {
+							sqe->opcode = (isRead) ? IORING_OP_READ : IORING_OP_WRITE;
+						}
+						
+						//An offset of -1 uses the current file offset
+						sqe->fd   = operation->fd;
+						sqe->addr = (uint64_t)(uintptr_t)operation->buffer;
+						sqe->len  = (unsigned int)std::min(operation->length, (size_t)ASYNC_MAX_TRANSFER);
+						sqe->off  = (uint64_t)operation->offset;
+						break;
+					}
+					
+					case ASYNC_OPEN:
+						sqe->opcode     = IORING_OP_OPENAT;
+						sqe->fd         = AT_FDCWD;
+						sqe->addr       = (uint64_t)(uintptr_t)operation->path.c_str();
+						sqe->len        = operation->mode;
+						sqe->open_flags = operation->flags;
+						break;
+					
+					case ASYNC_CLOSE:
+						sqe->opcode = IORING_OP_CLOSE;
+						sqe->fd     = operation->fd;
+						break;
+					
+					case ASYNC_STAT:
+					{
+						#ifdef STATX_BASIC_STATS
+						sqe->opcode = IORING_OP_STATX;
+						sqe->fd     = AT_FDCWD;
+						sqe->addr   = (uint64_t)(uintptr_t)operation->path.c_str();
+						sqe->len    = STATX_BASIC_STATS | STATX_BTIME;
+						sqe->off    = (uint64_t)(uintptr_t)&operation->extendedInfo;
+						break;
+						#else
+						
+						//Without the userspace statx() definitions, the query is performed immediately
+						operation->result = perform_operation(operation);
+						this->immediate.push_back(operation);
+						return;
+						
+						#endif
+					}
+				}
+				
+				this->sqArray[index] = index;
+				this->localTail++;
+			}
+			
+			unsigned int submit()
+			{
+				//Publish the new entries to the kernel and wait for it to consume them
+				__atomic_store_n(this->sqTail, this->localTail, __ATOMIC_RELEASE);
+				unsigned int count = this->unsubmitted();
+				while (this->unsubmitted() > 0)
+				{
+					if (this->enter(this->unsubmitted(), 0, 0) == -1 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+						break;
+					}
+				}
+				
+				return count - this->unsubmitted();
+			}
+			
+			void reap(unsigned int minCompletions, vector<AsyncOperation*>& completed)
+			{
+				unsigned int count = (unsigned int)this->immediate.size();
+				completed.insert(completed.end(), this->immediate.begin(), this->immediate.end());
+				this->immediate.clear();
+				
+				while (true)
+				{
+					count += this->collect(completed);
+					if (count >= minCompletions) {
+						return;
+					}
+					
+					//Any entries that could not be submitted earlier are submitted along with the wait
+					if (this->enter(this->unsubmitted(), minCompletions - count, IORING_ENTER_GETEVENTS) == -1 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+						return;
+					}
+				}
+			}
+		
+		private:
+			int enter(unsigned int toSubmit, unsigned int minCompletions, unsigned int flags) {
+				return (int)syscall(__NR_io_uring_enter, this->ringFd, toSubmit, minCompletions, flags, NULL, 0);
+			}
+			
+			//The number of published entries that the kernel has not yet consumed
+			unsigned int unsubmitted() {
+				return this->localTail - __atomic_load_n(this->sqHead, __ATOMIC_ACQUIRE);
+			}
+			
+			//Retrieves all available completions
+			unsigned int collect(vector<AsyncOperation*>& completed)
+			{
+				unsigned int head = *this->cqHead;
+				unsigned int tail = __atomic_load_n(this->cqTail, __ATOMIC_ACQUIRE);
+				unsigned int count = tail - head;
+				
+				for (; head != tail; ++head)
+				{
+					io_uring_cqe* cqe = &this->cqes[head & this->cqMask];
+					AsyncOperation* operation = (AsyncOperation*)(uintptr_t)cqe->user_data;
+					operation->result = cqe->res;
+					
+					#ifdef STATX_BASIC_STATS
+					if (operation->type == ASYNC_STAT) {
+						*operation->info = (cqe->res == 0) ? file_info_from_statx(operation->extendedInfo) : FileInfo();
+					}
+					#endif
+					
+					completed.push_back(operation);
+				}
+				
+				__atomic_store_n(this->cqHead, head, __ATOMIC_RELEASE);
+				return count;
+			}
+			
+			int ringFd;
+			void* sqRing;
+			void* cqRing;
+			io_uring_sqe* sqes;
+			size_t sqRingSize;
+			size_t cqRingSize;
+			size_t sqesSize;
+			
+			unsigned int* sqHead;
+			unsigned int* sqTail;
+			unsigned int* sqArray;
+			unsigned int sqMask;
+			unsigned int localTail;
+			
+			unsigned int* cqHead;
+			unsigned int* cqTail;
+			unsigned int cqMask;
+			io_uring_cqe* cqes;
+			
+			bool fixedBuffers;
+			vector<AsyncOperation*> immediate;
+	};
+	#endif
+}
+
+AsyncIO::AsyncIO(unsigned int queueDepth, unsigned int bufferCount, size_t bufferSize, bool allowIoUring)
+{
+	this->queueDepth = std::max(queueDepth, 1u);
+	this->operations = new AsyncOperation[this->queueDepth];
+	for (unsigned int i = this->queueDepth; i > 0; --i) {
+		this->freeOperations.push_back(&this->operations[i - 1]);
+	}
+	
+	//Allocate the buffer pool, rounding the buffer size up so that every buffer is aligned
+	this->bufferPool     = NULL;
+	this->poolBufferSize = (bufferSize + ASYNC_BUFFER_ALIGNMENT - 1) & ~(size_t)(ASYNC_BUFFER_ALIGNMENT - 1);
+	if (bufferCount > 0)
+	{
+		#ifdef _WIN32
+		this->bufferPool = (char*)_aligned_malloc(bufferCount * this->poolBufferSize, ASYNC_BUFFER_ALIGNMENT);
+		#else
+		if (posix_memalign((void**)&this->bufferPool, ASYNC_BUFFER_ALIGNMENT, bufferCount * this->poolBufferSize) != 0) {
+			this->bufferPool = NULL;
+		}
+		#endif
+		
+		for (unsigned int i = bufferCount; i > 0 && this->bufferPool != NULL; --i) {
+			this->freeBuffers.push_back(i - 1);
+		}
+	}
+	
+	this->engine = NULL;
+	
+	#ifdef USE_IO_URING
+	if (allowIoUring)
+	{
+		IoUringEngine* ring = new IoUringEngine();
+		if (ring->initialise(this->queueDepth, this->bufferPool, (unsigned int)this->freeBuffers.size(), this->poolBufferSize))
+		{
+			this->engine        = ring;
+			this->activeBackend = IO_URING;
+		}
+		else {
+			delete ring;
+		}
+	}
+	#endif
+	
+	if (this->engine == NULL)
+	{
+		this->engine        = new ThreadPoolEngine(std::min(this->queueDepth, (unsigned int)ASYNC_MAX_THREADS));
+		this->activeBackend = THREAD_POOL;
+	}
+}
+
+AsyncIO::~AsyncIO()
+{
+	this->drain();
+	delete this->engine;
+	delete[] this->operations;
+	
+	#ifdef _WIN32
+	_aligned_free(this->bufferPool);
+	#else
+	free(this->bufferPool);
+	#endif
+}
+
+void AsyncIO::read(int fd, char* buffer, size_t length, int64_t offset, const Callback& callback)
+{
+	AsyncOperation* operation = this->allocate(ASYNC_READ, callback);
+	operation->fd     = fd;
+	operation->buffer = buffer;
+	operation->length = length;
+	operation->offset = offset;
+	this->engine->queue(operation);
+}
+
+void AsyncIO::write(int fd, const char* buffer, size_t length, int64_t offset, const Callback& callback)
+{
+	AsyncOperation* operation = this->allocate(ASYNC_WRITE, callback);
+	operation->fd     = fd;
+	operation->buffer = const_cast<char*>(buffer);
+	operation->length = length;
+	operation->offset = offset;
+	this->engine->queue(operation);
+}
+
+void AsyncIO::open(const string& path, int flags, int mode, const Callback& callback)
+{
+	AsyncOperation* operation = this->allocate(ASYNC_OPEN, callback);
+	operation->path  = path;
+	operation->flags = flags;
+	operation->mode  = mode;
+	this->engine->queue(operation);
+}
+
+void AsyncIO::close(int fd, const Callback& callback)
+{
+	AsyncOperation* operation = this->allocate(ASYNC_CLOSE, callback);
+	operation->fd = fd;
+	this->engine->queue(operation);
+}
+
+void AsyncIO::stat(const string& path, FileInfo* info, const Callback& callback)
+{
+	AsyncOperation* operation = this->allocate(ASYNC_STAT, callback);
+	operation->path = path;
+	operation->info = info;
+	this->engine->queue(operation);
+}
+
+int AsyncIO::acquireBuffer()
+{
+	if (this->freeBuffers.empty()) {
+		return -1;
+	}
+	
+	int index = this->freeBuffers.back();
+	this->freeBuffers.pop_back();
+	return index;
+}
+
+void AsyncIO::releaseBuffer(int index) {
+	this->freeBuffers.push_back(index);
+}
+
+void AsyncIO::readFixed(int fd, int bufferIndex, size_t length, int64_t offset, const Callback& callback)
+{
+	AsyncOperation* operation = this->allocate(ASYNC_READ_FIXED, callback);
+	operation->fd          = fd;
+	operation->bufferIndex = bufferIndex;
+	operation->buffer      = this->buffer(bufferIndex);
+	operation->length      = std::min(length, this->poolBufferSize);
+	operation->offset      = offset;
+	this->engine->queue(operation);
+}
+
+void AsyncIO::writeFixed(int fd, int bufferIndex, size_t length, int64_t offset, const Callback& callback)
+{
+	AsyncOperation* operation = this->allocate(ASYNC_WRITE_FIXED, callback);
+	operation->fd          = fd;
+	operation->bufferIndex = bufferIndex;
+	operation->buffer      = this->buffer(bufferIndex);
+	operation->length      = std::min(length, this->poolBufferSize);
+	operation->offset      = offset;
+	this->engine->queue(operation);
+}
+
+unsigned int AsyncIO::submit() {
+	return this->engine->submit();
+}
+
+unsigned int AsyncIO::wait(unsigned int minCompletions)
+{
+	this->submit();
+	
+	//Never wait for more operations than are outstanding
+	vector<AsyncOperation*> completed;
+	this->engine->reap(std::min(minCompletions, this->outstanding()), completed);
+	
+	for (vector<AsyncOperation*>::iterator currOperation = completed.begin(); currOperation != completed.end(); ++currOperation)
+	{
+		//The operation is released before invoking the callback, so that the callback can queue another operation
+		AsyncOperation* operation = *currOperation;
+		Callback callback;
+		callback.swap(operation->callback);
+		this->freeOperations.push_back(operation);
+		callback(operation->result);
+	}
+	
+	return (unsigned int)completed.size();
+}
+
+void AsyncIO::drain()
+{
+	while (this->outstanding() > 0) {
+		this->wait(1);
+	}
+}
+
+AsyncOperation* AsyncIO::allocate(int type, const Callback& callback)
+{
+	//If the queue is full, wait for an operation to complete to make room
+	while (this->freeOperations.empty()) {
+		this->wait(1);
+	}
+	
+	AsyncOperation* operation = this->freeOperations.back();
+	this->freeOperations.pop_back();
+	operation->type     = type;
+	operation->callback = callback;
+	return operation;
+}
@@ -0,0 +1,148 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  Asynchronous File I/O
+//
+//  Allows a large number of read, write, open, close and stat operations to
+//  be in flight at once, so that tools which touch many files are not limited
+//  by the latency of each individual system call.
+//
+//  Under Linux, operations are performed using io_uring where the kernel
+//  supports it (5.6 or newer, and not disabled by the system administrator).
+//  Otherwise, operations are performed by a pool of worker threads using the
+//  regular blocking calls. The behaviour is identical under both backends.
+//
+//  Operations are queued by calling read(), write(), etc. and are started as
+//  a batch by calling submit(). Completion callbacks are only ever invoked on
+//  the thread that calls wait(), poll() or drain(), and receive the result of
+//  the operation: the number of bytes transferred (or the new descriptor, for
+//  open()), or a negative errno value on failure. Any buffers and FileInfo
+//  objects passed to an operation must remain valid until it completes.
+//
+//  At most queueDepth operations can be in flight. When queuing an operation
+//  while the queue is full, the queued operations are submitted and the call
+//  waits for an operation to complete (invoking its callback) to make room.
+//
+//  The optional buffer pool provides a fixed set of page-aligned buffers that
+//  are registered with the kernel once up front, avoiding the cost of mapping
+//  the buffer on every readFixed() or writeFixed() call. The pool is also
+//  suitable for use with descriptors opened with O_DIRECT.
+//
+//  An AsyncIO object must only be used by one thread at a time.
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _LIB_SIMPLE_BASE_ASYNC_IO_H
+#define _LIB_SIMPLE_BASE_ASYNC_IO_H
+
+#include "FileInfo.h"
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+struct AsyncOperation;
+class AsyncEngine;
+
+class AsyncIO
+{
+	public:
+		enum Backend
+		{
+			IO_URING,
+			THREAD_POOL
+		};
+		
+		typedef std::function<void(int64_t result)> Callback;
+		
+		//Creates a context that allows up to queueDepth operations in flight, with an optional pool of bufferCount buffers.
+		//Specifying allowIoUring as false forces the use of the thread pool backend (for comparison purposes).
+		AsyncIO(unsigned int queueDepth = 64, unsigned int bufferCount = 0, size_t bufferSize = 65536, bool allowIoUring = true);
+		
+		//Waits for all outstanding operations to complete (invoking their callbacks)
+		~AsyncIO();
+		
+		//The backend in use
+		Backend backend() const { return this->activeBackend; }
+		
+		//Queues a read or write at the specified offset (an offset of -1 uses and updates the current file offset)
+		void read(int fd, char* buffer, size_t length, int64_t offset, const Callback& callback);
+		void write(int fd, const char* buffer, size_t length, int64_t offset, const Callback& callback);
+		
+		//Queues an open or close call (the callback for open() receives the new descriptor)
+		void open(const string& path, int flags, int mode, const Callback& callback);
+		void close(int fd, const Callback& callback);
+		
+		//Queues a query of the specified path, storing the result in the supplied object
+		void stat(const string& path, FileInfo* info, const Callback& callback);
+		
+		//Acquires a buffer from the pool, returning its index (or -1 if none are available)
+		int acquireBuffer();
+		
+		//Returns a buffer to the pool
+		void releaseBuffer(int index);
+		
+		//Retrieves the pointer to a pool buffer, and the size of each buffer
+		char* buffer(int index) const { return this->bufferPool + ((size_t)index * this->poolBufferSize); }
+		size_t bufferSize() const { return this->poolBufferSize; }
+		
+		//Queues a read or write using a pool buffer (the length must not exceed the buffer size)
+		void readFixed(int fd, int bufferIndex, size_t length, int64_t offset, const Callback& callback);
+		void writeFixed(int fd, int bufferIndex, size_t length, int64_t offset, const Callback& callback);
+		
+		//Starts all queued operations, returning the number of operations started
+		unsigned int submit();
+		
+		//Submits any queued operations and waits until at least the specified number of operations have completed,
+		//invoking their callbacks. Returns the number of callbacks invoked.
+		unsigned int wait(unsigned int minCompletions = 1);
+		
+		//Invokes the callbacks of any operations that have completed, without waiting
+		unsigned int poll() { return this->wait(0); }
+		
+		//Submits any queued operations and waits for all outstanding operations to complete
+		void drain();
+		
+		//The number of operations that have been queued or submitted but have not yet completed
+		unsigned int outstanding() const { return this->queueDepth - (unsigned int)this->freeOperations.size(); }
+	
+	private:
+		AsyncIO(const AsyncIO& other);
+		AsyncIO& operator=(const AsyncIO& other);
+		
+		//Retrieves an unused operation, waiting for one to become available if necessary
+		AsyncOperation* allocate(int type, const Callback& callback);
+		
+		Backend activeBackend;
+		AsyncEngine* engine;
+		
+		unsigned int queueDepth;
+		AsyncOperation* operations;
+		vector<AsyncOperation*> freeOperations;
+		
+		char* bufferPool;
+		size_t poolBufferSize;
+		vector<int> freeBuffers;
+};
+
+#endif
@@ -0,0 +1,213 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  Binary Reader Class
+//
+//  Reads typed little-endian and big-endian values from an in-memory buffer,
+//  a memory-mapped file or a file descriptor.
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "BinaryReader.h"
+
+#include <errno.h>
+
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
+
+BinaryReader::BinaryReader(const char* data, size_t length)
+{
+	this->data        = data;
+	this->length      = length;
+	this->offset      = 0;
+	this->windowStart = 0;
+	this->error       = false;
+	this->fd          = -1;
+	this->bufferSize  = 0;
+}
+
+BinaryReader::BinaryReader(string_view data)
+{
+	this->data        = data.data();
+	this->length      = data.length();
+	this->offset      = 0;
+	this->windowStart = 0;
+	this->error       = false;
+	this->fd          = -1;
+	this->bufferSize  = 0;
+}
+
+BinaryReader::BinaryReader(const MappedFile& file)
+{
+	this->data        = file.data();
+	this->length      = file.size();
+	this->offset      = 0;
+	this->windowStart = 0;
+	this->error       = false;
+	this->fd          = -1;
+	this->bufferSize  = 0;
+}
+
+BinaryReader::BinaryReader(int fd, size_t bufferSize)
+{
+	this->data        = NULL;
+	this->length      = 0;
+	this->offset      = 0;
+	this->error       = false;
+	this->fd          = fd;
+	this->bufferSize  = (bufferSize > 0) ? bufferSize : 64 * 1024;
+	
+	//Positions are reported relative to the start of the file, so start from the descriptor's current offset
+	#ifdef _WIN32
+	int64_t start = _lseeki64(fd, 0, SEEK_CUR);
+	#else
+	int64_t start = lseek(fd, 0, SEEK_CUR);
+	#endif
+	this->windowStart = (start > 0) ? start : 0;
+}
+
+bool BinaryReader::read(char* dest, size_t count)
+{
+	if (!this->ensure(count)) {
+		return false;
+	}
+	
+	memcpy(dest, this->data + this->offset, count);
+	this->offset += count;
+	return true;
+}
+
+string_view BinaryReader::view(size_t count)
+{
+	if (!this->ensure(count)) {
+		return string_view();
+	}
+	
+	string_view result(this->data + this->offset, count);
+	this->offset += count;
+	return result;
+}
+
+BinaryReader BinaryReader::record(size_t count) {
+	return BinaryReader(this->view(count));
+}
+
+bool BinaryReader::skip(size_t count)
+{
+	//When reading from a file descriptor, skip buffered data first and then seek past the rest
+	size_t available = this->length - this->offset;
+	if (count > available && this->fd != -1) {
+		return this->seek(this->position() + count);
+	}
+	
+	if (!this->ensure(count)) {
+		return false;
+	}
+	
+	this->offset += count;
+	return true;
+}
+
+bool BinaryReader::seek(uint64_t position)
+{
+	//Positions within the current window (which is the entire data for in-memory buffers) don't require any I/O
+	if (position >= this->windowStart && position - this->windowStart <= this->length)
+	{
+		this->offset = position - this->windowStart;
+		return true;
+	}
+	
+	if (this->fd == -1)
+	{
+		this->error = true;
+		return false;
+	}
+	
+	//Discard the buffered data and seek the descriptor itself
+	#ifdef _WIN32
+	bool success = (_lseeki64(this->fd, position, SEEK_SET) != -1);
+	#else
+	bool success = (lseek(this->fd, position, SEEK_SET) != -1);
+	#endif
+	
+	if (!success)
+	{
+		this->error = true;
+		return false;
+	}
+	
+	this->windowStart = position;
+	this->length      = 0;
+	this->offset      = 0;
+	return true;
+}
+
+bool BinaryReader::atEnd() {
+	return (this->offset == this->length && !this->refill(1));
+}
+
+bool BinaryReader::refill(size_t count)
+{
+	if (this->fd == -1) {
+		return false;
+	}
+	
+	//Move any unread data to the start of the buffer
+	size_t leftover = this->length - this->offset;
+	if (leftover > 0 && this->offset > 0) {
+		memmove(&this->buffer[0], &this->buffer[this->offset], leftover);
+	}
+	
+	//Grow the buffer if a single read requires more than the buffer size
+	size_t required = (count > this->bufferSize) ? count : this->bufferSize;
+	if (this->buffer.size() < required) {
+		this->buffer.resize(required);
+	}
+	
+	this->windowStart += this->offset;
+	this->offset       = 0;
+	this->data         = &this->buffer[0];
+	this->length       = leftover;
+	
+	//Read until we have enough data or reach the end of the file
+	while (this->length < count)
+	{
+		#ifdef _WIN32
+		int bytesRead = _read(this->fd, &this->buffer[this->length], (unsigned int)(this->buffer.size() - this->length));
+		#else
+		ssize_t bytesRead = ::read(this->fd, &this->buffer[this->length], this->buffer.size() - this->length);
+		#endif
+		
+		if (bytesRead == -1 && errno == EINTR) {
+			continue;
+		}
+		else if (bytesRead <= 0) {
+			return false;
+		}
+		
+		this->length += bytesRead;
+	}
+	
+	return true;
+}
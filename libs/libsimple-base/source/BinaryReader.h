@@ -0,0 +1,141 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  Binary Reader Class
+//
+//  Reads typed little-endian and big-endian values from an in-memory buffer,
+//  a memory-mapped file or a file descriptor, tracking the current position
+//  itself rather than querying or seeking the underlying stream.
+//
+//  When reading from a file descriptor, data is buffered in large chunks and
+//  the file offset of the descriptor advances as each chunk is read.
+//
+//  Reading past the end of the data sets the failure flag and returns zero
+//  values (or empty views), so that a parser can perform a series of reads
+//  and check failed() once at the end.
+//
+//  Views returned by view() point directly into the underlying buffer, and
+//  when reading from a file descriptor they are invalidated by the next read.
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _LIB_SIMPLE_BASE_BINARY_READER_H
+#define _LIB_SIMPLE_BASE_BINARY_READER_H
+
+#include "endianness.h"
+#include "file_manipulation.h"
+#include <stdint.h>
+#include <string_view>
+#include <vector>
+using std::string_view;
+using std::vector;
+
+class BinaryReader
+{
+	public:
+		//Reads from an in-memory buffer or mapping (which must outlive the reader)
+		BinaryReader(const char* data, size_t length);
+		BinaryReader(string_view data);
+		BinaryReader(const MappedFile& file);
+		
+		//Reads from a file descriptor, starting at its current offset and buffering the specified number of bytes at a time
+		BinaryReader(int fd, size_t bufferSize);
+		
+		//Typed reads, in little-endian and big-endian byte order
+		template <typename T>
+		T readLE()
+		{
+			if (!this->ensure(sizeof(T))) {
+				return T();
+			}
+			
+			T value = loadLittleEndian<T>(this->data + this->offset);
+			this->offset += sizeof(T);
+			return value;
+		}
+		
+		template <typename T>
+		T readBE()
+		{
+			if (!this->ensure(sizeof(T))) {
+				return T();
+			}
+			
+			T value = loadBigEndian<T>(this->data + this->offset);
+			this->offset += sizeof(T);
+			return value;
+		}
+		
+		//Copies the specified number of bytes into the supplied buffer
+		bool read(char* dest, size_t count);
+		
+		//Retrieves a view of the next count bytes and advances past them (empty if fewer than count bytes remain)
+		string_view view(size_t count);
+		
+		//Retrieves a reader bounded to the next count bytes and advances past them, for parsing a fixed-size record or chunk
+		BinaryReader record(size_t count);
+		
+		//Advances past the specified number of bytes
+		bool skip(size_t count);
+		
+		//Moves to the specified absolute position (for file descriptors, this requires the descriptor to be seekable)
+		bool seek(uint64_t position);
+		
+		//The current absolute position
+		uint64_t position() const { return this->windowStart + this->offset; }
+		
+		//Determines if there is no more data to read
+		bool atEnd();
+		
+		//Determines if any read has gone past the end of the data (or any seek has failed)
+		bool failed() const { return this->error; }
+	
+	private:
+		//Copying a reader over a file descriptor would leave the copy pointing into the original's buffer
+		BinaryReader(const BinaryReader& other);
+		BinaryReader& operator=(const BinaryReader& other);
+		
+		//Ensures that at least count bytes are available, setting the failure flag if they are not
+		bool ensure(size_t count)
+		{
+			if (this->length - this->offset >= count || this->refill(count)) {
+				return true;
+			}
+			
+			this->error = true;
+			return false;
+		}
+		
+		//Reads more data from the file descriptor so that at least count bytes are available
+		bool refill(size_t count);
+		
+		const char* data;
+		size_t length;
+		size_t offset;
+		uint64_t windowStart;
+		bool error;
+		
+		int fd;
+		size_t bufferSize;
+		vector<char> buffer;
+};
+
+#endif
@@ -0,0 +1,131 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  Binary Writer Class
+//
+//  Writes typed little-endian and big-endian values into a fixed-size buffer,
+//  a string or a file descriptor.
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "BinaryWriter.h"
+#include "file_manipulation.h"
+
+BinaryWriter::BinaryWriter(char* data, size_t capacity)
+{
+	this->fixed      = data;
+	this->capacity   = capacity;
+	this->target     = NULL;
+	this->fd         = -1;
+	this->bufferSize = 0;
+	this->written    = 0;
+	this->error      = false;
+}
+
+BinaryWriter::BinaryWriter(string& output)
+{
+	this->fixed      = NULL;
+	this->capacity   = 0;
+	this->target     = &output;
+	this->fd         = -1;
+	this->bufferSize = 0;
+	this->written    = 0;
+	this->error      = false;
+}
+
+BinaryWriter::BinaryWriter(int fd, size_t bufferSize)
+{
+	this->fixed      = NULL;
+	this->capacity   = 0;
+	this->target     = NULL;
+	this->fd         = fd;
+	this->bufferSize = (bufferSize > 0) ? bufferSize : 64 * 1024;
+	this->written    = 0;
+	this->error      = false;
+	this->buffer.reserve(this->bufferSize);
+}
+
+BinaryWriter::~BinaryWriter()
+{
+	if (this->fd != -1) {
+		this->flush();
+	}
+}
+
+bool BinaryWriter::write(const char* source, size_t count)
+{
+	if (this->fixed != NULL)
+	{
+		if (count > this->capacity - this->written)
+		{
+			this->error = true;
+			return false;
+		}
+		
+		memcpy(this->fixed + this->written, source, count);
+	}
+	else if (this->target != NULL) {
+		this->target->append(source, count);
+	}
+	else
+	{
+		this->buffer.append(source, count);
+		if (this->buffer.length() >= this->bufferSize && !this->flush()) {
+			return false;
+		}
+	}
+	
+	this->written += count;
+	return true;
+}
+
+bool BinaryWriter::flush()
+{
+	//Nothing to do when writing to memory
+	if (this->fd == -1) {
+		return !this->error;
+	}
+	
+	if (!write_all(this->fd, this->buffer.data(), this->buffer.length())) {
+		this->error = true;
+	}
+	
+	this->buffer.clear();
+	return !this->error;
+}
+
+char* BinaryWriter::patchTarget(size_t position, size_t count)
+{
+	if (position > this->written || count > this->written - position) {
+		return NULL;
+	}
+	
+	if (this->fixed != NULL) {
+		return this->fixed + position;
+	}
+	
+	//The string may already have contained data before the writer was created, so positions are relative to where we started
+	if (this->target != NULL) {
+		return &(*this->target)[this->target->length() - this->written + position];
+	}
+	
+	return NULL;
+}
@@ -0,0 +1,135 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  Binary Writer Class
+//
+//  Writes typed little-endian and big-endian values into a fixed-size buffer,
+//  a string (which grows as needed) or a file descriptor, tracking the
+//  current position itself rather than querying the underlying stream.
+//
+//  When writing to a file descriptor, data is buffered and written out each
+//  time the buffer fills. Any remaining data is written by flush() or by the
+//  destructor, and must be flushed before anything else writes to the same
+//  descriptor.
+//
+//  Writing past the end of a fixed-size buffer (or a failed write to a file
+//  descriptor) sets the failure flag and discards the data.
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _LIB_SIMPLE_BASE_BINARY_WRITER_H
+#define _LIB_SIMPLE_BASE_BINARY_WRITER_H
+
+#include "endianness.h"
+#include <stdint.h>
+#include <string>
+#include <string_view>
+using std::string;
+using std::string_view;
+
+class BinaryWriter
+{
+	public:
+		//Writes into a fixed-size buffer
+		BinaryWriter(char* data, size_t capacity);
+		
+		//Appends to the supplied string (which must outlive the writer)
+		BinaryWriter(string& output);
+		
+		//Writes to a file descriptor, buffering the specified number of bytes at a time
+		BinaryWriter(int fd, size_t bufferSize);
+		
+		//Flushes any remaining data when writing to a file descriptor
+		~BinaryWriter();
+		
+		//Typed writes, in little-endian and big-endian byte order
+		template <typename T>
+		bool writeLE(T value)
+		{
+			char bytes[sizeof(T)];
+			storeLittleEndian<T>(bytes, value);
+			return this->write(bytes, sizeof(T));
+		}
+		
+		template <typename T>
+		bool writeBE(T value)
+		{
+			char bytes[sizeof(T)];
+			storeBigEndian<T>(bytes, value);
+			return this->write(bytes, sizeof(T));
+		}
+		
+		//Writes the supplied bytes
+		bool write(const char* source, size_t count);
+		bool write(string_view source) { return this->write(source.data(), source.length()); }
+		
+		//Overwrites a previously-written value, such as a size field that is only known once the data following it has been written
+		//(only supported when writing to a buffer or string)
+		template <typename T>
+		bool patchLE(size_t position, T value)
+		{
+			char* dest = this->patchTarget(position, sizeof(T));
+			if (dest != NULL) {
+				storeLittleEndian<T>(dest, value);
+			}
+			
+			return (dest != NULL);
+		}
+		
+		template <typename T>
+		bool patchBE(size_t position, T value)
+		{
+			char* dest = this->patchTarget(position, sizeof(T));
+			if (dest != NULL) {
+				storeBigEndian<T>(dest, value);
+			}
+			
+			return (dest != NULL);
+		}
+		
+		//Writes any buffered data to the file descriptor, returning false if writing failed
+		bool flush();
+		
+		//The number of bytes written so far
+		uint64_t position() const { return this->written; }
+		
+		//Determines if any write has failed
+		bool failed() const { return this->error; }
+	
+	private:
+		//Copying a writer that writes to a file descriptor would result in duplicate output
+		BinaryWriter(const BinaryWriter& other);
+		BinaryWriter& operator=(const BinaryWriter& other);
+		
+		//Locates previously-written data for patching, returning NULL if it is unavailable
+		char* patchTarget(size_t position, size_t count);
+		
+		char*    fixed;
+		size_t   capacity;
+		string*  target;
+		int      fd;
+		size_t   bufferSize;
+		string   buffer;
+		uint64_t written;
+		bool     error;
+};
+
+#endif
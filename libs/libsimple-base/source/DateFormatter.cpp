@@ -0,0 +1,280 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  Date Formatter
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "DateFormatter.h"
+#include "time.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+//The number of formatters whose output each thread caches at once (formatters whose identifiers collide evict one another)
+#define DATE_FORMATTER_CACHE_SLOTS 8
+
+//The letters treated as specifiers when symbols are inserted (matching date())
+#define DATE_FORMATTER_SYMBOLS "aAbBcdHIjmMpSUwWxXyYZ"
+
+//The strftime() specifiers whose output only changes once per day
+#define DATE_FORMATTER_DAILY_SPECIFIERS "aAbBCdDeFgGhjmuUVwWxyY"
+
+//The output of a formatter for a single second, cached by each thread
+struct DateFormatter::Cache
+{
+	uint64_t formatterId;
+	time_t second;
+	int64_t day;
+	vector<string> outputs;     //The output of each operation
+	vector<string> segments;    //The combined output of the operations between each sub-second field
+	
+	Cache() : formatterId(0), second(0), day(0) {}
+};
+
+//Identifiers start at one, so that zero denotes an empty cache slot
+static std::atomic<uint64_t> nextFormatterId(1);
+
+//Writes a value as a fixed number of decimal digits
+static void write_digits(char* output, unsigned int value, int numDigits)
+{
+	for (int i = numDigits - 1; i >= 0; --i)
+	{
+		output[i] = (char)('0' + (value % 10));
+		value /= 10;
+	}
+}
+
+DateFormatter::DateFormatter(const string& format, bool insertSymbols)
+{
+	this->id = nextFormatterId++;
+	
+	//Insert % symbols in the format string
+	string expanded = format;
+	if (insertSymbols)
+	{
+		expanded.clear();
+		for (size_t i = 0; i < format.length(); ++i)
+		{
+			if (strchr(DATE_FORMATTER_SYMBOLS, format[i]) != NULL) {
+				expanded.append(1, '%');
+			}
+			
+			expanded.append(1, format[i]);
+		}
+	}
+	
+	//Parse the format string into a list of operations
+	for (size_t i = 0; i < expanded.length(); ++i)
+	{
+		if (expanded[i] != '%' || i + 1 == expanded.length())
+		{
+			this->addLiteral(string(1, expanded[i]));
+			continue;
+		}
+		
+		Operation operation;
+		operation.daily = true;
+		char specifier = expanded[i + 1];
+		if (expanded.compare(i, 4, "%suf") == 0)
+		{
+			//Render the day without a leading zero when it is directly followed by its suffix
+			if (!this->operations.empty() && this->operations.back().type == Specifier && this->operations.back().text == "%d") {
+				this->operations.back().type = UnpaddedDay;
+			}
+			
+			operation.type = DaySuffix;
+			i += 3;
+		}
+		else if (specifier == '%')
+		{
+			this->addLiteral("%");
+			i++;
+			continue;
+		}
+		else if (specifier == 'L' || specifier == 'f' || specifier == 'N')
+		{
+			operation.type = (specifier == 'L') ? Milliseconds : ((specifier == 'f') ? Microseconds : Nanoseconds);
+			operation.daily = false;
+			this->subSecondFields.push_back(operation.type);
+			i++;
+		}
+		else
+		{
+			//Include the E and O modifiers along with the specifier that follows them
+			size_t length = ((specifier == 'E' || specifier == 'O') && i + 2 < expanded.length()) ? 3 : 2;
+			operation.type = Specifier;
+			operation.text = expanded.substr(i, length);
+			operation.daily = (strchr(DATE_FORMATTER_DAILY_SPECIFIERS, operation.text[length - 1]) != NULL);
+			i += length - 1;
+		}
+		
+		this->operations.push_back(operation);
+	}
+}
+
+size_t DateFormatter::format(char* buffer, size_t bufferSize, time_t timestamp, int nanoseconds) const
+{
+	static thread_local Cache caches[DATE_FORMATTER_CACHE_SLOTS];
+	Cache& cache = caches[this->id % DATE_FORMATTER_CACHE_SLOTS];
+	if (cache.formatterId != this->id || cache.second != timestamp) {
+		this->refresh(cache, timestamp);
+	}
+	
+	if (nanoseconds < 0 || nanoseconds > 999999999) {
+		nanoseconds = 0;
+	}
+	
+	//Copy the cached segments, rendering the sub-second fields between them
+	size_t length = 0;
+	for (size_t i = 0; i < cache.segments.size(); ++i)
+	{
+		const string& segment = cache.segments[i];
+		if (length + segment.length() >= bufferSize) {
+			return (size_t)-1;
+		}
+		
+		memcpy(buffer + length, segment.data(), segment.length());
+		length += segment.length();
+		
+		if (i < this->subSecondFields.size())
+		{
+			OperationType field = this->subSecondFields[i];
+			int numDigits = (field == Milliseconds) ? 3 : ((field == Microseconds) ? 6 : 9);
+			unsigned int value = (field == Milliseconds) ? nanoseconds / 1000000 : ((field == Microseconds) ? nanoseconds / 1000 : nanoseconds);
+			if (length + numDigits >= bufferSize) {
+				return (size_t)-1;
+			}
+			
+			write_digits(buffer + length, value, numDigits);
+			length += numDigits;
+		}
+	}
+	
+	if (length >= bufferSize) {
+		return (size_t)-1;
+	}
+	
+	buffer[length] = 0;
+	return length;
+}
+
+size_t DateFormatter::formatNow(char* buffer, size_t bufferSize) const
+{
+	timespec now;
+	timespec_get(&now, TIME_UTC);
+	return this->format(buffer, bufferSize, now.tv_sec, (int)now.tv_nsec);
+}
+
+string DateFormatter::format(time_t timestamp, int nanoseconds) const
+{
+	vector<char> buffer(256);
+	size_t length = 0;
+	while ((length = this->format(buffer.data(), buffer.size(), timestamp, nanoseconds)) == (size_t)-1) {
+		buffer.resize(buffer.size() * 2);
+	}
+	
+	return string(buffer.data(), length);
+}
+
+void DateFormatter::addLiteral(const string& text)
+{
+	if (!this->operations.empty() && this->operations.back().type == Literal)
+	{
+		this->operations.back().text += text;
+		return;
+	}
+	
+	Operation operation;
+	operation.type = Literal;
+	operation.text = text;
+	operation.daily = true;
+	this->operations.push_back(operation);
+}
+
+void DateFormatter::refresh(Cache& cache, time_t timestamp) const
+{
+	//Within the same day, only the fields that change more often than once per day need to be rendered again
+	int64_t day = (timestamp >= 0) ? timestamp / 86400 : ((timestamp + 1) / 86400) - 1;
+	bool renderAll = (cache.formatterId != this->id || cache.day != day);
+	if (cache.formatterId != this->id)
+	{
+		cache.formatterId = this->id;
+		cache.outputs.assign(this->operations.size(), string());
+	}
+	
+	tm timeDetails;
+	#ifdef _WIN32
+	gmtime_s(&timeDetails, &timestamp);
+	#else
+	gmtime_r(&timestamp, &timeDetails);
+	#endif
+	
+	char rendered[256];
+	for (size_t i = 0; i < this->operations.size(); ++i)
+	{
+		const Operation& operation = this->operations[i];
+		if (!renderAll && operation.daily) {
+			continue;
+		}
+		
+		string& output = cache.outputs[i];
+		switch (operation.type)
+		{
+			case Literal:
+				output = operation.text;
+				break;
+			
+			case Specifier:
+				output.assign(rendered, strftime(rendered, sizeof(rendered), operation.text.c_str(), &timeDetails));
+				break;
+			
+			case DaySuffix:
+				output = monthSuffix(timeDetails.tm_mday);
+				break;
+			
+			case UnpaddedDay:
+				output.assign(rendered, snprintf(rendered, sizeof(rendered), "%d", timeDetails.tm_mday));
+				break;
+			
+			default:
+				output.clear();
+				break;
+		}
+	}
+	
+	//Combine the output of the operations between each of the sub-second fields
+	cache.segments.assign(1, string());
+	for (size_t i = 0; i < this->operations.size(); ++i)
+	{
+		OperationType type = this->operations[i].type;
+		if (type == Milliseconds || type == Microseconds || type == Nanoseconds) {
+			cache.segments.push_back(string());
+		}
+		else {
+			cache.segments.back() += cache.outputs[i];
+		}
+	}
+	
+	cache.second = timestamp;
+	cache.day = day;
+}
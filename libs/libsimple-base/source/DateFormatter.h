@@ -0,0 +1,106 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  Date Formatter
+//
+//  Formats UTC timestamps in the same way as date(), but parses the format
+//  string only once, into a list of operations. The output of the fields
+//  that only change once per day (such as the year, month and day) and
+//  once per second (such as the hour, minute and second) is cached, so
+//  formatting successive timestamps within the same second only needs to
+//  render the sub-second fields, which makes the formatter suitable for
+//  stamping every line of a high-volume log.
+//
+//  In addition to the strftime() specifiers and %suf (the English ordinal
+//  suffix for the day of the month), the following sub-second specifiers
+//  are supported:
+//  
+//  %L    Milliseconds (3 digits)
+//  %f    Microseconds (6 digits)
+//  %N    Nanoseconds (9 digits)
+//  
+//  When %d is immediately followed by %suf, the day is rendered without a
+//  leading zero (as date() does for days surrounded by spaces).
+//
+//  Caches are kept per thread (keyed by formatter), so a single formatter
+//  can be shared between any number of threads without locking.
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _LIB_SIMPLE_BASE_DATE_FORMATTER_H
+#define _LIB_SIMPLE_BASE_DATE_FORMATTER_H
+
+#include <ctime>
+#include <stdint.h>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+class DateFormatter
+{
+	public:
+		//Compiles the format string (if insertSymbols is true, a % symbol is inserted before each specifier letter, as with date())
+		DateFormatter(const string& format, bool insertSymbols = false);
+		
+		//Formats the timestamp into the supplied buffer, returning the length of the output (excluding the null terminator),
+		//or (size_t)-1 if the buffer is too small (an empty format produces an empty string and returns zero)
+		size_t format(char* buffer, size_t bufferSize, time_t timestamp, int nanoseconds = 0) const;
+		
+		//Formats the current time into the supplied buffer
+		size_t formatNow(char* buffer, size_t bufferSize) const;
+		
+		//Formats the timestamp as a string
+		string format(time_t timestamp, int nanoseconds = 0) const;
+	
+	private:
+		enum OperationType
+		{
+			Literal,
+			Specifier,
+			DaySuffix,
+			UnpaddedDay,
+			Milliseconds,
+			Microseconds,
+			Nanoseconds
+		};
+		
+		struct Operation
+		{
+			OperationType type;
+			string text;        //The literal text, or the strftime() specifier
+			bool daily;         //Whether the output changes at most once per day
+		};
+		
+		struct Cache;
+		
+		//Appends literal text, merging it with the previous operation if that was also literal text
+		void addLiteral(const string& text);
+		
+		//Renders the cached output of every operation that changes within the specified second
+		void refresh(Cache& cache, time_t timestamp) const;
+		
+		uint64_t id;
+		vector<Operation> operations;
+		vector<OperationType> subSecondFields;
+};
+
+#endif
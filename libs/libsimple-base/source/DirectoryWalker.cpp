@@ -0,0 +1,528 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  Recursive Directory Walker
+//
+//  Walks a directory tree using a work-stealing pool of threads.
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "DirectoryWalker.h"
+#include "string_manipulation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <dirent.h>
+	#include <unistd.h>
+#endif
+
+//Under Linux, we call getdents64() directly so that we can control the size of the buffer
+#ifdef __linux__
+	#include <sys/syscall.h>
+	#define USE_GETDENTS
+#endif
+
+//The size of the buffer used when reading directories, which determines the number of entries retrieved per call
+#define WALK_BUFFER_SIZE (256 * 1024)
+
+namespace
+{
+	enum EntryType
+	{
+		ENTRY_UNKNOWN,
+		ENTRY_FILE,
+		ENTRY_DIRECTORY,
+		ENTRY_SYMLINK,
+		ENTRY_OTHER
+	};
+	
+	struct RawEntry
+	{
+		string   name;
+		int      type;
+		uint64_t inode;
+	};
+	
+	struct WalkTask
+	{
+		string path;
+		string relative;
+		int    depth;
+	};
+	
+	typedef std::pair<uint64_t, uint64_t> DirectoryIdentity;
+	
+	#ifdef USE_GETDENTS
+	struct LinuxDirent64
+	{
+		uint64_t       d_ino;
+		int64_t        d_off;
+		unsigned short d_reclen;
+		unsigned char  d_type;
+		char           d_name[1];
+	};
+	#endif
+	
+	#ifndef _WIN32
+	int type_from_mode(mode_t mode)
+	{
+		if (S_ISREG(mode)) { return ENTRY_FILE; }
+		if (S_ISDIR(mode)) { return ENTRY_DIRECTORY; }
+		if (S_ISLNK(mode)) { return ENTRY_SYMLINK; }
+		return ENTRY_OTHER;
+	}
+	
+	int type_from_dirent(unsigned char type)
+	{
+		#ifdef DT_UNKNOWN
+		switch (type)
+		{
+			case DT_REG: return ENTRY_FILE;
+			case DT_DIR: return ENTRY_DIRECTORY;
+			case DT_LNK: return ENTRY_SYMLINK;
+			case DT_UNKNOWN: return ENTRY_UNKNOWN;
+			default: return ENTRY_OTHER;
+		}
+		#else
+		return ENTRY_UNKNOWN;
+		#endif
+	}
+	
+	//Determines the type of an entry when the filesystem did not report it (or when resolving a symlink)
+	void resolve_type(int directoryFd, RawEntry& entry, bool followSymlinks)
+	{
+		struct stat info;
+		if (entry.type == ENTRY_UNKNOWN && fstatat(directoryFd, entry.name.c_str(), &info, AT_SYMLINK_NOFOLLOW) == 0) {
+			entry.type = type_from_mode(info.st_mode);
+		}
+		
+		//Broken symlinks are reported as symlinks
+		if (entry.type == ENTRY_SYMLINK && followSymlinks && fstatat(directoryFd, entry.name.c_str(), &info, 0) == 0) {
+			entry.type = type_from_mode(info.st_mode);
+		}
+	}
+	#endif
+	
+	//Reads the entries of a directory (excluding . and ..), optionally retrieving its device and inode number
+	bool read_directory(const string& path, bool followSymlinks, vector<RawEntry>& entries, vector<char>& buffer, DirectoryIdentity* identity)
+	{
+		#if defined(_WIN32)
+		
+		WIN32_FIND_DATAA data;
+		HANDLE handle = FindFirstFileExA((path + "\\*").c_str(), FindExInfoBasic, &data, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+		if (handle == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+		
+		do
+		{
+			if (strcmp(data.cFileName, ".") == 0 || strcmp(data.cFileName, "..") == 0) {
+				continue;
+			}
+			
+			RawEntry entry;
+			entry.name  = data.cFileName;
+			entry.inode = 0;
+			if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+				entry.type = (followSymlinks && !(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) ? ENTRY_FILE : ENTRY_SYMLINK;
+			}
+			else {
+				entry.type = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ? ENTRY_DIRECTORY : ENTRY_FILE;
+			}
+			
+			entries.push_back(entry);
+		}
+		while (FindNextFileA(handle, &data));
+		
+		FindClose(handle);
+		return true;
+		
+		#else
+		
+		int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (fd == -1) {
+			return false;
+		}
+		
+		struct stat info;
+		if (identity != NULL && fstat(fd, &info) == 0) {
+			*identity = DirectoryIdentity(info.st_dev, info.st_ino);
+		}
+		
+		#ifdef USE_GETDENTS
+		
+		long bytesRead = 0;
+		while ((bytesRead = syscall(SYS_getdents64, fd, buffer.data(), buffer.size())) > 0)
+		{
+			for (long offset = 0; offset < bytesRead;)
+			{
+				LinuxDirent64* current = (LinuxDirent64*)(buffer.data() + offset);
+				offset += current->d_reclen;
+				
+				const char* name = current->d_name;
+				if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+					continue;
+				}
+				
+				RawEntry entry;
+				entry.name  = name;
+				entry.type  = type_from_dirent(current->d_type);
+				entry.inode = current->d_ino;
+				resolve_type(fd, entry, followSymlinks);
+				entries.push_back(entry);
+			}
+		}
+		
+		close(fd);
+		
+		#else
+		
+		DIR* directory = fdopendir(fd);
+		if (directory == NULL)
+		{
+			close(fd);
+			return false;
+		}
+		
+		dirent* current = NULL;
+		while ((current = readdir(directory)) != NULL)
+		{
+			const char* name = current->d_name;
+			if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+				continue;
+			}
+			
+			RawEntry entry;
+			entry.name  = name;
+			#ifdef DT_UNKNOWN
+			entry.type  = type_from_dirent(current->d_type);
+			#else
+			entry.type  = ENTRY_UNKNOWN;
+			#endif
+			entry.inode = current->d_ino;
+			resolve_type(fd, entry, followSymlinks);
+			entries.push_back(entry);
+		}
+		
+		closedir(directory);
+		
+		#endif
+		
+		return true;
+		
+		#endif
+	}
+	
+	class TreeWalker
+	{
+		public:
+			TreeWalker(const WalkOptions& options, const WalkCallback& callback, unsigned int threads) :
+				options(options), callback(callback), queues(threads), outstanding(0), queued(0), idle(0), stopped(false), rootFailed(false)
+			{}
+			
+			bool run(const string& root)
+			{
+				WalkTask rootTask;
+				rootTask.path  = root;
+				rootTask.depth = 0;
+				
+				vector<WalkTask> tasks(1, rootTask);
+				this->pushTasks(0, tasks);
+				
+				//The calling thread acts as the first worker
+				vector<std::thread> workers;
+				for (unsigned int i = 1; i < this->queues.size(); ++i) {
+					workers.push_back(std::thread(&TreeWalker::work, this, i));
+				}
+				
+				this->work(0);
+				for (vector<std::thread>::iterator worker = workers.begin(); worker != workers.end(); ++worker) {
+					worker->join();
+				}
+				
+				return !this->rootFailed && !this->stopped;
+			}
+		
+		private:
+			struct WorkerQueue
+			{
+				std::mutex mutex;
+				std::deque<WalkTask> tasks;
+			};
+			
+			void work(unsigned int index)
+			{
+				vector<char> buffer(WALK_BUFFER_SIZE);
+				vector<RawEntry> entries;
+				vector<WalkEntry> results;
+				vector<WalkTask> subdirectories;
+				WalkTask task;
+				
+				while (true)
+				{
+					if (this->takeTask(index, task))
+					{
+						this->processDirectory(index, task, buffer, entries, results, subdirectories);
+						if (--this->outstanding == 0) {
+							this->wakeIdleWorkers();
+						}
+						
+						continue;
+					}
+					
+					//No work is available, so wait until more is queued or the walk is complete
+					std::unique_lock<std::mutex> lock(this->idleMutex);
+					this->idle++;
+					this->idleCondition.wait(lock, [this]() { return this->outstanding == 0 || this->queued > 0; });
+					this->idle--;
+					if (this->outstanding == 0) {
+						return;
+					}
+				}
+			}
+			
+			bool takeTask(unsigned int index, WalkTask& task)
+			{
+				if (this->queued == 0) {
+					return false;
+				}
+				
+				//Take the most recently queued directory from our own queue, which keeps the walk close to depth-first
+				{
+					WorkerQueue& own = this->queues[index];
+					std::lock_guard<std::mutex> lock(own.mutex);
+					if (!own.tasks.empty())
+					{
+						task = std::move(own.tasks.back());
+						own.tasks.pop_back();
+						this->queued--;
+						return true;
+					}
+				}
+				
+				//Otherwise, steal the oldest directory from another queue, since it is likely to contain the largest subtree
+				for (unsigned int i = 1; i < this->queues.size(); ++i)
+				{
+					WorkerQueue& victim = this->queues[(index + i) % this->queues.size()];
+					std::lock_guard<std::mutex> lock(victim.mutex);
+					if (!victim.tasks.empty())
+					{
+						task = std::move(victim.tasks.front());
+						victim.tasks.pop_front();
+						this->queued--;
+						return true;
+					}
+				}
+				
+				return false;
+			}
+			
+			void pushTasks(unsigned int index, vector<WalkTask>& tasks)
+			{
+				if (tasks.empty()) {
+					return;
+				}
+				
+				//The outstanding count is increased first, so that a worker woken by the new tasks never sees it reach zero
+				this->outstanding += tasks.size();
+				{
+					WorkerQueue& own = this->queues[index];
+					std::lock_guard<std::mutex> lock(own.mutex);
+					for (vector<WalkTask>::iterator task = tasks.begin(); task != tasks.end(); ++task) {
+						own.tasks.push_back(std::move(*task));
+					}
+					
+					this->queued += tasks.size();
+				}
+				
+				tasks.clear();
+				if (this->idle > 0) {
+					this->wakeIdleWorkers();
+				}
+			}
+			
+			void wakeIdleWorkers()
+			{
+				//Acquiring the mutex ensures that a worker that is about to wait sees the updated counts
+				{
+					std::lock_guard<std::mutex> lock(this->idleMutex);
+				}
+				
+				this->idleCondition.notify_all();
+			}
+			
+			bool matches(const vector<string>& patterns, const string& name, const string& relative)
+			{
+				for (vector<string>::const_iterator pattern = patterns.begin(); pattern != patterns.end(); ++pattern)
+				{
+					if (wildcard_match(*pattern, (pattern->find('/') != string::npos) ? relative : name)) {
+						return true;
+					}
+				}
+				
+				return false;
+			}
+			
+			void processDirectory(unsigned int index, const WalkTask& task, vector<char>& buffer, vector<RawEntry>& entries, vector<WalkEntry>& results, vector<WalkTask>& subdirectories)
+			{
+				if (this->stopped) {
+					return;
+				}
+				
+				entries.clear();
+				results.clear();
+				
+				DirectoryIdentity identity(0, 0);
+				bool trackVisited = this->options.followSymlinks;
+				if (!read_directory(task.path, this->options.followSymlinks, entries, buffer, (trackVisited) ? &identity : NULL))
+				{
+					if (task.depth == 0) {
+						this->rootFailed = true;
+					}
+					
+					return;
+				}
+				
+				//When following symlinks, a directory may be reachable by more than one path (or contain a link to itself)
+				if (trackVisited)
+				{
+					std::lock_guard<std::mutex> lock(this->visitedMutex);
+					if (!this->visited.insert(identity).second) {
+						return;
+					}
+				}
+				
+				string prefix = task.path;
+				if (!prefix.empty() && prefix[prefix.length() - 1] != '/' && prefix[prefix.length() - 1] != '\\') {
+					prefix += "/";
+				}
+				
+				//Entries deeper than the maximum depth are never reported (so a maximum depth of zero reports nothing)
+				int depth = task.depth + 1;
+				if (this->options.maxDepth >= 0 && depth > this->options.maxDepth) {
+					return;
+				}
+				
+				bool descend = (this->options.maxDepth < 0 || depth < this->options.maxDepth);
+				for (vector<RawEntry>::iterator entry = entries.begin(); entry != entries.end(); ++entry)
+				{
+					string relative = (task.relative.empty()) ? entry->name : task.relative + "/" + entry->name;
+					if (this->matches(this->options.exclude, entry->name, relative)) {
+						continue;
+					}
+					
+					bool isDirectory = (entry->type == ENTRY_DIRECTORY);
+					if (isDirectory && descend)
+					{
+						WalkTask subdirectory;
+						subdirectory.path     = prefix + entry->name;
+						subdirectory.relative = relative;
+						subdirectory.depth    = depth;
+						subdirectories.push_back(subdirectory);
+					}
+					
+					bool report = (isDirectory) ? this->options.includeDirectories : (this->options.include.empty() || this->matches(this->options.include, entry->name, relative));
+					if (report)
+					{
+						WalkEntry result;
+						result.path        = prefix + entry->name;
+						result.name        = entry->name;
+						result.depth       = depth;
+						result.isDirectory = isDirectory;
+						result.isRegular   = (entry->type == ENTRY_FILE);
+						result.isSymlink   = (entry->type == ENTRY_SYMLINK);
+						result.inode       = entry->inode;
+						results.push_back(result);
+					}
+				}
+				
+				//Queue the subdirectories before invoking the callback, so that other threads can start on them
+				this->pushTasks(index, subdirectories);
+				
+				std::lock_guard<std::mutex> lock(this->callbackMutex);
+				for (vector<WalkEntry>::iterator result = results.begin(); result != results.end() && !this->stopped; ++result)
+				{
+					if (!this->callback(*result)) {
+						this->stopped = true;
+					}
+				}
+			}
+			
+			const WalkOptions& options;
+			const WalkCallback& callback;
+			vector<WorkerQueue> queues;
+			
+			std::atomic<int64_t> outstanding;
+			std::atomic<int64_t> queued;
+			std::atomic<unsigned int> idle;
+			std::mutex idleMutex;
+			std::condition_variable idleCondition;
+			
+			std::atomic<bool> stopped;
+			std::atomic<bool> rootFailed;
+			std::mutex callbackMutex;
+			
+			std::mutex visitedMutex;
+			std::set<DirectoryIdentity> visited;
+	};
+}
+
+WalkOptions::WalkOptions()
+{
+	this->maxDepth           = -1;
+	this->includeDirectories = false;
+	this->followSymlinks     = false;
+	this->threads            = 0;
+}
+
+bool walk_directory(const string& root, const WalkCallback& callback, const WalkOptions& options)
+{
+	unsigned int threads = (options.threads > 0) ? options.threads : std::max(std::thread::hardware_concurrency(), 1u);
+	TreeWalker walker(options, callback, threads);
+	return walker.run(root);
+}
+
+vector<string> walk_directory(const string& root, const WalkOptions& options)
+{
+	//The callback is never invoked concurrently, so no locking is required
+	vector<string> paths;
+	walk_directory(root, [&paths](const WalkEntry& entry) -> bool
+	{
+		paths.push_back(entry.path);
+		return true;
+	}, options);
+	
+	std::sort(paths.begin(), paths.end());
+	return paths;
+}
@@ -0,0 +1,86 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  Recursive Directory Walker
+//
+//  Walks a directory tree using a pool of threads, with each thread taking
+//  subdirectories from its own queue and stealing from the queues of other
+//  threads when its own queue is empty.
+//
+//  Under Linux, directories are read using getdents64() with a large buffer,
+//  and the entry type reported by the filesystem is used wherever possible,
+//  so that entries only need to be queried individually when the filesystem
+//  does not report their type (or when following symlinks).
+//
+//  Results are streamed to a callback as each directory is read, so trees
+//  containing millions of entries do not need to be held in memory. The
+//  callback is invoked from the worker threads, but never concurrently, and
+//  the order in which entries are reported is not deterministic.
+//
+//  Under Windows, directory symlinks and junctions are never descended into.
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _LIB_SIMPLE_BASE_DIRECTORY_WALKER_H
+#define _LIB_SIMPLE_BASE_DIRECTORY_WALKER_H
+
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+struct WalkEntry
+{
+	string   path;          //The path of the entry, including the root path
+	string   name;          //The name of the entry within its directory
+	int      depth;         //1 for entries directly inside the root directory
+	bool     isDirectory;
+	bool     isRegular;
+	bool     isSymlink;     //True for symlinks that are not being followed (including broken symlinks)
+	uint64_t inode;         //Zero under Windows
+};
+
+struct WalkOptions
+{
+	//Patterns are matched using wildcard_match() against the name of each entry, or against the path relative to
+	//the root for patterns that contain a slash
+	vector<string> include;      //Patterns that files must match, or an empty list to include all files
+	vector<string> exclude;      //Patterns for entries to skip (excluded directories are not descended into)
+	int  maxDepth;               //The maximum depth of the entries to report, or -1 for no limit
+	bool includeDirectories;     //Report directories as well as files (directories are not subject to the include patterns)
+	bool followSymlinks;         //Treat symlinks as the entries they point to, descending into linked directories (each directory is visited once)
+	unsigned int threads;        //The number of threads to use (zero means one per core)
+	
+	WalkOptions();
+};
+
+typedef std::function<bool(const WalkEntry& entry)> WalkCallback;
+
+//Walks the directory tree, invoking the callback for each matching entry. The walk stops when the callback returns false.
+//Returns false if the root directory could not be read or the walk was stopped by the callback.
+bool walk_directory(const string& root, const WalkCallback& callback, const WalkOptions& options = WalkOptions());
+
+//Walks the directory tree, returning the sorted paths of all matching entries
+vector<string> walk_directory(const string& root, const WalkOptions& options = WalkOptions());
+
+#endif
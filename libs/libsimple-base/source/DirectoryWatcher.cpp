@@ -0,0 +1,314 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  Directory Watcher (Linux only)
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "DirectoryWatcher.h"
+
+#ifdef __linux__
+
+#include "DirectoryWalker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+
+//The size of the buffer used when reading events, which determines the number of events retrieved per call
+#define WATCH_BUFFER_SIZE (256 * 1024)
+
+//A batch is never held open for longer than this multiple of the coalescing window
+#define WATCH_MAX_COALESCE_WINDOWS 10
+
+//Strips any trailing slashes from a directory path, so that the paths of watches and events are well-formed
+static string strip_trailing_slashes(const string& path)
+{
+	string stripped = path;
+	while (stripped.length() > 1 && stripped[stripped.length() - 1] == '/') {
+		stripped.erase(stripped.length() - 1);
+	}
+	
+	return stripped;
+}
+
+DirectoryWatcher::DirectoryWatcher(uint32_t mask, unsigned int coalesceMs)
+{
+	this->inotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	this->mask = mask;
+	this->coalesceMs = coalesceMs;
+	this->buffer.resize(WATCH_BUFFER_SIZE);
+}
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+	if (this->inotifyDescriptor != -1) {
+		close(this->inotifyDescriptor);
+	}
+}
+
+bool DirectoryWatcher::addDirectory(const string& path, bool recursive)
+{
+	string root = strip_trailing_slashes(path);
+	if (!this->addWatch(root, recursive)) {
+		return false;
+	}
+	
+	//For recursive watches, watch all of the existing subdirectories (the callback is never invoked concurrently)
+	bool succeeded = true;
+	if (recursive)
+	{
+		WalkOptions options;
+		options.includeDirectories = true;
+		walk_directory(root, [this, &succeeded](const WalkEntry& entry)
+		{
+			if (entry.isDirectory && !this->addWatch(entry.path, true)) {
+				succeeded = false;
+			}
+			
+			return true;
+		}, options);
+	}
+	
+	return succeeded;
+}
+
+bool DirectoryWatcher::removeDirectory(const string& path)
+{
+	string root = strip_trailing_slashes(path);
+	for (map<int, Watch>::iterator watch = this->watches.begin(); watch != this->watches.end(); ++watch)
+	{
+		if (watch->second.path == root)
+		{
+			inotify_rm_watch(this->inotifyDescriptor, watch->first);
+			this->watches.erase(watch);
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+bool DirectoryWatcher::readEvents(vector<WatchEvent>& events, int timeoutMs)
+{
+	events.clear();
+	map<string, size_t> coalesced;
+	
+	//Wait for the first events (events used only to manage our watches are not reported, so we may need to wait again)
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+	while (events.empty())
+	{
+		if (this->watches.empty()) {
+			return false;
+		}
+		
+		int waitMs = -1;
+		if (timeoutMs >= 0)
+		{
+			int64_t remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+			if (remaining < 0) {
+				return true;
+			}
+			
+			waitMs = (int)remaining;
+		}
+		
+		if (this->readAvailable(waitMs, events, coalesced) == -1) {
+			return false;
+		}
+		
+		if (timeoutMs == 0) {
+			break;
+		}
+	}
+	
+	//Keep the batch open until no events have arrived for the length of the coalescing window
+	if (this->coalesceMs > 0 && !events.empty())
+	{
+		std::chrono::steady_clock::time_point batchDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(this->coalesceMs * WATCH_MAX_COALESCE_WINDOWS);
+		while (true)
+		{
+			int64_t remaining = std::chrono::duration_cast<std::chrono::milliseconds>(batchDeadline - std::chrono::steady_clock::now()).count();
+			if (remaining <= 0) {
+				break;
+			}
+			
+			int numRead = this->readAvailable((int)std::min(remaining, (int64_t)this->coalesceMs), events, coalesced);
+			if (numRead == -1) {
+				return false;
+			}
+			else if (numRead == 0) {
+				break;
+			}
+		}
+	}
+	
+	return true;
+}
+
+void DirectoryWatcher::run(const WatchCallback& callback)
+{
+	vector<WatchEvent> events;
+	while (this->readEvents(events))
+	{
+		if (!events.empty() && !callback(events)) {
+			return;
+		}
+	}
+}
+
+bool DirectoryWatcher::addWatch(const string& path, bool recursive)
+{
+	//Recursive watches also need to know when subdirectories are created or moved in, even if those events are not being reported
+	uint32_t watchMask = this->mask | IN_ONLYDIR;
+	if (recursive) {
+		watchMask |= IN_CREATE | IN_MOVED_TO;
+	}
+	
+	int watchDescriptor = inotify_add_watch(this->inotifyDescriptor, path.c_str(), watchMask);
+	if (watchDescriptor == -1) {
+		return false;
+	}
+	
+	Watch watch;
+	watch.path = path;
+	watch.recursive = recursive;
+	this->watches[watchDescriptor] = watch;
+	return true;
+}
+
+int DirectoryWatcher::readAvailable(int timeoutMs, vector<WatchEvent>& events, map<string, size_t>& coalesced)
+{
+	struct pollfd descriptor = {this->inotifyDescriptor, POLLIN, 0};
+	int numReady = poll(&descriptor, 1, timeoutMs);
+	if (numReady <= 0) {
+		return (numReady == 0 || errno == EINTR) ? 0 : -1;
+	}
+	
+	ssize_t length = read(this->inotifyDescriptor, this->buffer.data(), this->buffer.size());
+	if (length == -1) {
+		return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+	}
+	
+	//Events are variable in size, since each one is followed by the (padded) name of the entry it relates to
+	int numRead = 0;
+	for (ssize_t offset = 0; offset < length; numRead++)
+	{
+		const inotify_event* event = (const inotify_event*)(this->buffer.data() + offset);
+		offset += sizeof(inotify_event) + event->len;
+		
+		WatchEvent result;
+		result.mask   = event->mask;
+		result.cookie = event->cookie;
+		
+		//Ignore events for watches that have been removed, and remove watches when the kernel tells us it has removed them
+		map<int, Watch>::iterator watch = this->watches.find(event->wd);
+		if (event->mask & IN_Q_OVERFLOW) {
+			result.path = "";
+		}
+		else if (watch == this->watches.end()) {
+			continue;
+		}
+		else if (event->mask & IN_IGNORED)
+		{
+			this->watches.erase(watch);
+			continue;
+		}
+		else
+		{
+			result.path = (event->len > 0) ? watch->second.path + "/" + string(event->name) : watch->second.path;
+			
+			//For recursive watches, watch any new subdirectories (reporting the event for the subdirectory before those for its contents)
+			bool newDirectory = (watch->second.recursive && (event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)));
+			if (event->mask & this->mask) {
+				this->appendEvent(result, events, coalesced);
+			}
+			
+			if (newDirectory) {
+				this->watchNewDirectory(result.path, events, coalesced);
+			}
+			
+			continue;
+		}
+		
+		this->appendEvent(result, events, coalesced);
+	}
+	
+	return numRead;
+}
+
+void DirectoryWatcher::watchNewDirectory(const string& path, vector<WatchEvent>& events, map<string, size_t>& coalesced)
+{
+	//Add the watch before scanning the directory, so that any entries created after the scan generate their own events
+	if (!this->addWatch(path, true)) {
+		return;
+	}
+	
+	WalkOptions options;
+	options.maxDepth = 1;
+	options.includeDirectories = true;
+	options.threads = 1;
+	
+	vector<string> subdirectories;
+	walk_directory(path, [this, &events, &coalesced, &subdirectories](const WalkEntry& entry)
+	{
+		if (this->mask & IN_CREATE)
+		{
+			WatchEvent created;
+			created.path   = entry.path;
+			created.mask   = (entry.isDirectory) ? (IN_CREATE | IN_ISDIR) : IN_CREATE;
+			created.cookie = 0;
+			this->appendEvent(created, events, coalesced);
+		}
+		
+		if (entry.isDirectory) {
+			subdirectories.push_back(entry.path);
+		}
+		
+		return true;
+	}, options);
+	
+	for (vector<string>::iterator subdirectory = subdirectories.begin(); subdirectory != subdirectories.end(); ++subdirectory) {
+		this->watchNewDirectory(*subdirectory, events, coalesced);
+	}
+}
+
+void DirectoryWatcher::appendEvent(const WatchEvent& event, vector<WatchEvent>& events, map<string, size_t>& coalesced)
+{
+	//When coalescing, merge events for the same path (but keep the events for renames distinct, so their cookies can be matched)
+	if (this->coalesceMs > 0 && event.cookie == 0 && !(event.mask & IN_Q_OVERFLOW))
+	{
+		map<string, size_t>::iterator existing = coalesced.find(event.path);
+		if (existing != coalesced.end())
+		{
+			events[existing->second].mask |= event.mask;
+			return;
+		}
+		
+		coalesced[event.path] = events.size();
+	}
+	
+	events.push_back(event);
+}
+
+#endif
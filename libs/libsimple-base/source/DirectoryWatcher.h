@@ -0,0 +1,134 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  Directory Watcher (Linux only)
+//
+//  Watches any number of directories (optionally including all of their
+//  subdirectories) for changes using a single inotify descriptor, and reads
+//  the resulting events in batches using a large buffer.
+//
+//  When a coalescing window is specified, each batch is held open until no
+//  new events have arrived for the length of the window (or until ten times
+//  the window has elapsed, so that a constant stream of events cannot delay
+//  a batch indefinitely), and multiple events for the same path within a
+//  batch are merged into a single event whose mask combines all of them.
+//  This turns a burst of writes to a file into a single notification.
+//
+//  For recursive watches, subdirectories that are created or moved into a
+//  watched directory are watched automatically. Since entries created inside
+//  a new subdirectory before its watch is added do not generate events, the
+//  new subdirectory is scanned once its watch is in place and a synthesized
+//  IN_CREATE event (with IN_ISDIR for directories) is reported for each entry
+//  found. An entry created while the scan is taking place may be reported by
+//  both a synthesized event and a real one.
+//
+//  If the kernel's event queue overflows, an event with an empty path and
+//  the IN_Q_OVERFLOW flag is reported, and the caller should rescan the
+//  watched directories.
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _LIB_SIMPLE_BASE_DIRECTORY_WATCHER_H
+#define _LIB_SIMPLE_BASE_DIRECTORY_WATCHER_H
+
+#ifdef __linux__
+
+#include <functional>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <sys/inotify.h>
+using std::map;
+using std::string;
+using std::vector;
+
+struct WatchEvent
+{
+	string   path;      //The path of the affected entry, including the path of the watched directory
+	uint32_t mask;      //The IN_* flags describing the event (IN_ISDIR is set for directories)
+	uint32_t cookie;    //Links the IN_MOVED_FROM and IN_MOVED_TO events for a rename, or zero for other events
+};
+
+typedef std::function<bool(const vector<WatchEvent>& events)> WatchCallback;
+
+class DirectoryWatcher
+{
+	public:
+		//Creates a watcher that reports the specified events (a combination of IN_* flags), coalescing events over the specified window
+		DirectoryWatcher(uint32_t mask = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO, unsigned int coalesceMs = 0);
+		~DirectoryWatcher();
+		
+		//Determines if the inotify descriptor was created successfully
+		bool isOpen() const { return this->inotifyDescriptor != -1; }
+		
+		//The inotify descriptor, which becomes readable when events are available (for use with poll() or epoll)
+		int descriptor() const { return this->inotifyDescriptor; }
+		
+		//Starts watching a directory, optionally including all of its subdirectories. Returns false if the directory (or any subdirectory) could not be watched.
+		bool addDirectory(const string& path, bool recursive = false);
+		
+		//Stops watching a directory (but not its subdirectories)
+		bool removeDirectory(const string& path);
+		
+		//The number of directories being watched
+		size_t watchCount() const { return this->watches.size(); }
+		
+		//Waits up to timeoutMs for events (-1 waits indefinitely, 0 does not wait), replacing the contents of events with the next batch.
+		//Returns false if an error occurred or there are no directories left to watch (a timeout returns true with an empty batch).
+		bool readEvents(vector<WatchEvent>& events, int timeoutMs = -1);
+		
+		//Reads batches of events and passes them to the callback, until the callback returns false or readEvents() fails
+		void run(const WatchCallback& callback);
+	
+	private:
+		DirectoryWatcher(const DirectoryWatcher& other);
+		DirectoryWatcher& operator=(const DirectoryWatcher& other);
+		
+		struct Watch
+		{
+			string path;
+			bool recursive;
+		};
+		
+		//Adds a watch for a single directory
+		bool addWatch(const string& path, bool recursive);
+		
+		//Watches a subdirectory that appeared inside a recursive watch (along with its own subdirectories), reporting synthesized
+		//IN_CREATE events for the entries that were already inside it
+		void watchNewDirectory(const string& path, vector<WatchEvent>& events, map<string, size_t>& coalesced);
+		
+		//Adds an event to the batch, merging it with any earlier event for the same path when coalescing
+		void appendEvent(const WatchEvent& event, vector<WatchEvent>& events, map<string, size_t>& coalesced);
+		
+		//Waits up to timeoutMs for the descriptor to become readable and reads all available events, returning -1 on error
+		int readAvailable(int timeoutMs, vector<WatchEvent>& events, map<string, size_t>& coalesced);
+		
+		int inotifyDescriptor;
+		uint32_t mask;
+		unsigned int coalesceMs;
+		map<int, Watch> watches;
+		vector<char> buffer;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,302 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  File Information Queries
+//
+//  Retrieves all of the commonly-needed metadata for a filesystem entry
+//  using a single call.
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "FileInfo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+	#include <unistd.h>
+#endif
+
+#ifdef __linux__
+	#include <sys/sysmacros.h>
+#endif
+
+//statx() is available under Linux from glibc 2.28 onwards
+#if defined(__linux__) && defined(STATX_BASIC_STATS)
+	#define USE_STATX
+#endif
+
+namespace
+{
+	int64_t to_nanoseconds(int64_t seconds, int64_t nanoseconds) {
+		return (seconds * 1000000000LL) + nanoseconds;
+	}
+	
+	void fill_from_stat(const struct stat& fileInfo, FileInfo& info)
+	{
+		info.exists = true;
+		info.mode   = fileInfo.st_mode;
+		info.size   = fileInfo.st_size;
+		info.device = fileInfo.st_dev;
+		info.inode  = fileInfo.st_ino;
+		info.links  = fileInfo.st_nlink;
+		
+		#if defined(_WIN32)
+		info.isRegular   = ((fileInfo.st_mode & _S_IFMT) == _S_IFREG);
+		info.isDirectory = ((fileInfo.st_mode & _S_IFMT) == _S_IFDIR);
+		info.accessed    = to_nanoseconds(fileInfo.st_atime, 0);
+		info.modified    = to_nanoseconds(fileInfo.st_mtime, 0);
+		info.changed     = to_nanoseconds(fileInfo.st_ctime, 0);
+		#else
+		info.isRegular   = S_ISREG(fileInfo.st_mode);
+		info.isDirectory = S_ISDIR(fileInfo.st_mode);
+		info.isSymlink   = S_ISLNK(fileInfo.st_mode);
+		#if defined(__APPLE__)
+		info.accessed    = to_nanoseconds(fileInfo.st_atimespec.tv_sec, fileInfo.st_atimespec.tv_nsec);
+		info.modified    = to_nanoseconds(fileInfo.st_mtimespec.tv_sec, fileInfo.st_mtimespec.tv_nsec);
+		info.changed     = to_nanoseconds(fileInfo.st_ctimespec.tv_sec, fileInfo.st_ctimespec.tv_nsec);
+		info.created     = to_nanoseconds(fileInfo.st_birthtimespec.tv_sec, fileInfo.st_birthtimespec.tv_nsec);
+		#else
+		info.accessed    = to_nanoseconds(fileInfo.st_atim.tv_sec, fileInfo.st_atim.tv_nsec);
+		info.modified    = to_nanoseconds(fileInfo.st_mtim.tv_sec, fileInfo.st_mtim.tv_nsec);
+		info.changed     = to_nanoseconds(fileInfo.st_ctim.tv_sec, fileInfo.st_ctim.tv_nsec);
+		#endif
+		#endif
+	}
+	
+	#ifdef USE_STATX
+	void fill_from_statx(const struct statx& fileInfo, FileInfo& info)
+	{
+		info.exists      = true;
+		info.mode        = fileInfo.stx_mode;
+		info.isRegular   = S_ISREG(fileInfo.stx_mode);
+		info.isDirectory = S_ISDIR(fileInfo.stx_mode);
+		info.isSymlink   = S_ISLNK(fileInfo.stx_mode);
+		info.size        = fileInfo.stx_size;
+		info.device      = makedev(fileInfo.stx_dev_major, fileInfo.stx_dev_minor);
+		info.inode       = fileInfo.stx_ino;
+		info.links       = fileInfo.stx_nlink;
+		info.accessed    = to_nanoseconds(fileInfo.stx_atime.tv_sec, fileInfo.stx_atime.tv_nsec);
+		info.modified    = to_nanoseconds(fileInfo.stx_mtime.tv_sec, fileInfo.stx_mtime.tv_nsec);
+		info.changed     = to_nanoseconds(fileInfo.stx_ctime.tv_sec, fileInfo.stx_ctime.tv_nsec);
+		
+		//Not all filesystems record the creation time
+		if (fileInfo.stx_mask & STATX_BTIME) {
+			info.created = to_nanoseconds(fileInfo.stx_btime.tv_sec, fileInfo.stx_btime.tv_nsec);
+		}
+	}
+	#endif
+	
+	#ifndef _WIN32
+	FileInfo stat_at(int directoryFd, const char* path, int flags)
+	{
+		FileInfo info;
+		
+		#ifdef USE_STATX
+		
+		struct statx extendedInfo;
+		if (statx(directoryFd, path, flags, STATX_BASIC_STATS | STATX_BTIME, &extendedInfo) == 0)
+		{
+			fill_from_statx(extendedInfo, info);
+			return info;
+		}
+		
+		//Fall back to fstatat() for kernels that predate statx()
+		if (errno != ENOSYS) {
+			return info;
+		}
+		
+		#endif
+		
+		struct stat fileInfo;
+		if (fstatat(directoryFd, path, &fileInfo, flags) == 0) {
+			fill_from_stat(fileInfo, info);
+		}
+		
+		return info;
+	}
+	#endif
+	
+	int64_t steady_milliseconds()
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()
+		).count();
+	}
+}
+
+FileInfo::FileInfo()
+{
+	this->exists      = false;
+	this->isRegular   = false;
+	this->isDirectory = false;
+	this->isSymlink   = false;
+	this->mode        = 0;
+	this->size        = 0;
+	this->device      = 0;
+	this->inode       = 0;
+	this->links       = 0;
+	this->accessed    = 0;
+	this->modified    = 0;
+	this->changed     = 0;
+	this->created     = 0;
+}
+
+FileInfo file_info(const string& path, bool followSymlinks)
+{
+	#ifdef _WIN32
+	
+	FileInfo info;
+	struct stat fileInfo;
+	if (stat(path.c_str(), &fileInfo) == 0) {
+		fill_from_stat(fileInfo, info);
+	}
+	
+	return info;
+	
+	#else
+	return stat_at(AT_FDCWD, path.c_str(), (followSymlinks) ? 0 : AT_SYMLINK_NOFOLLOW);
+	#endif
+}
+
+FileInfo file_info(int fd)
+{
+	#ifdef USE_STATX
+	
+	//An empty path with AT_EMPTY_PATH queries the descriptor itself
+	return stat_at(fd, "", AT_EMPTY_PATH);
+	
+	#else
+	
+	FileInfo info;
+	struct stat fileInfo;
+	if (fstat(fd, &fileInfo) == 0) {
+		fill_from_stat(fileInfo, info);
+	}
+	
+	return info;
+	
+	#endif
+}
+
+vector<FileInfo> file_info_batch(const string& directory, const vector<string>& names, bool followSymlinks)
+{
+	#ifdef _WIN32
+	
+	vector<FileInfo> results;
+	results.reserve(names.size());
+	for (vector<string>::const_iterator currName = names.begin(); currName != names.end(); ++currName) {
+		results.push_back(file_info(directory + "/" + *currName, followSymlinks));
+	}
+	
+	return results;
+	
+	#else
+	
+	//If the directory cannot be opened, none of the names can be queried
+	int directoryFd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+	if (directoryFd == -1) {
+		return vector<FileInfo>(names.size());
+	}
+	
+	vector<FileInfo> results = file_info_batch(directoryFd, names, followSymlinks);
+	close(directoryFd);
+	return results;
+	
+	#endif
+}
+
+#ifndef _WIN32
+vector<FileInfo> file_info_batch(int directoryFd, const vector<string>& names, bool followSymlinks)
+{
+	int flags = (followSymlinks) ? 0 : AT_SYMLINK_NOFOLLOW;
+	
+	vector<FileInfo> results;
+	results.reserve(names.size());
+	for (vector<string>::const_iterator currName = names.begin(); currName != names.end(); ++currName) {
+		results.push_back(stat_at(directoryFd, currName->c_str(), flags));
+	}
+	
+	return results;
+}
+#endif
+
+#ifdef USE_STATX
+FileInfo file_info_from_statx(const struct statx& extendedInfo)
+{
+	FileInfo info;
+	fill_from_statx(extendedInfo, info);
+	return info;
+}
+#endif
+
+//The minimum number of entries before the cache is swept for expired entries
+#define FILE_INFO_CACHE_MIN_SWEEP 1024
+
+FileInfoCache::FileInfoCache(int64_t maxAgeMs)
+{
+	this->maxAge = maxAgeMs;
+	this->sweepThreshold = FILE_INFO_CACHE_MIN_SWEEP;
+}
+
+const FileInfo& FileInfoCache::get(const string& path)
+{
+	int64_t now = steady_milliseconds();
+	
+	//Remove expired entries whenever the cache has doubled in size since the last sweep, so the cost of sweeping is amortised
+	//across the queries and the cache never grows much beyond the number of paths queried within the expiry period
+	if (this->entries.size() >= this->sweepThreshold)
+	{
+		for (unordered_map<string, Entry>::iterator existing = this->entries.begin(); existing != this->entries.end();)
+		{
+			if (now - existing->second.retrieved > this->maxAge) {
+				existing = this->entries.erase(existing);
+			}
+			else {
+				++existing;
+			}
+		}
+		
+		this->sweepThreshold = std::max((size_t)FILE_INFO_CACHE_MIN_SWEEP, this->entries.size() * 2);
+	}
+	
+	Entry& entry = this->entries[path];
+	
+	//Newly-created entries have a retrieval time of zero, so they are always queried
+	if (entry.retrieved == 0 || now - entry.retrieved > this->maxAge)
+	{
+		entry.info      = file_info(path);
+		entry.retrieved = now;
+	}
+	
+	return entry.info;
+}
+
+void FileInfoCache::invalidate(const string& path) {
+	this->entries.erase(path);
+}
+
+void FileInfoCache::clear() {
+	this->entries.clear();
+}
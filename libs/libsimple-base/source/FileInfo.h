@@ -0,0 +1,115 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  File Information Queries
+//
+//  Retrieves all of the commonly-needed metadata for a filesystem entry
+//  using a single call, rather than the separate stat() call made by each of
+//  file_exists(), is_dir(), filesize() and file_last_modified(). Under Linux,
+//  statx() is used where available, which also provides the creation time.
+//  Timestamps are expressed in nanoseconds since the Unix epoch.
+//
+//  The batch query resolves each name relative to an open directory
+//  descriptor, so the directory path is only traversed once.
+//
+//  FileInfoCache retains results for a short period, for tools that query
+//  the same paths repeatedly. Expired entries are removed periodically, so
+//  the cache only holds the paths queried recently. It is not thread-safe.
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _LIB_SIMPLE_BASE_FILE_INFO_H
+#define _LIB_SIMPLE_BASE_FILE_INFO_H
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+struct FileInfo
+{
+	bool     exists;        //False if the entry could not be queried (in which case the remaining fields are zero)
+	bool     isRegular;
+	bool     isDirectory;
+	bool     isSymlink;     //Only ever true when symlinks are not being followed
+	uint32_t mode;          //The st_mode value, including the file type bits
+	int64_t  size;          //The size in bytes
+	uint64_t device;
+	uint64_t inode;
+	uint64_t links;
+	int64_t  accessed;      //Last access time
+	int64_t  modified;      //Last modification time
+	int64_t  changed;       //Last status change time
+	int64_t  created;       //Creation time (zero when the filesystem does not provide it)
+	
+	FileInfo();
+};
+
+//Queries the specified path, or the entry referred to by an open file descriptor
+FileInfo file_info(const string& path, bool followSymlinks = true);
+FileInfo file_info(int fd);
+
+//Queries each of the specified names relative to a directory (names that are absolute paths are queried as-is)
+vector<FileInfo> file_info_batch(const string& directory, const vector<string>& names, bool followSymlinks = true);
+
+#ifndef _WIN32
+vector<FileInfo> file_info_batch(int directoryFd, const vector<string>& names, bool followSymlinks = true);
+#endif
+
+#ifdef __linux__
+//Converts the result of a statx() call made elsewhere (such as by AsyncIO)
+FileInfo file_info_from_statx(const struct statx& extendedInfo);
+#endif
+
+class FileInfoCache
+{
+	public:
+		//Creates a cache whose entries expire after the specified number of milliseconds
+		FileInfoCache(int64_t maxAgeMs = 1000);
+		
+		//Retrieves the information for the specified path, querying it if it is not cached or has expired.
+		//The returned reference remains valid until the next call to any of the cache's methods.
+		const FileInfo& get(const string& path);
+		
+		//Removes the specified path from the cache (for example, after modifying the file)
+		void invalidate(const string& path);
+		
+		//Removes all paths from the cache
+		void clear();
+	
+	private:
+		struct Entry
+		{
+			FileInfo info;
+			int64_t  retrieved;
+			
+			Entry() : retrieved(0) {}
+		};
+		
+		unordered_map<string, Entry> entries;
+		int64_t maxAge;
+		size_t sweepThreshold;
+};
+
+#endif
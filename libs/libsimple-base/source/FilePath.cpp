@@ -0,0 +1,133 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  File Path Class
+//
+//  Stores a file path and the offsets of its last separator and extension
+//  period, which are located once upon construction. The basename, dirname
+//  and extension queries then return views into the stored path rather
+//  than allocating new strings the way the free functions do.
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "FilePath.h"
+
+FilePath::FilePath()
+{
+	this->slashPos = string::npos;
+	this->dotPos   = string::npos;
+}
+
+FilePath::FilePath(const string& path) : path(path) {
+	this->parse();
+}
+
+FilePath::FilePath(const char* path) : path(path) {
+	this->parse();
+}
+
+string_view FilePath::basename() const
+{
+	string_view view(this->path);
+	return (this->slashPos != string::npos) ? view.substr(this->slashPos + 1) : view;
+}
+
+string_view FilePath::dirname() const
+{
+	//No separator means the file is in the current directory
+	if (this->slashPos == string::npos) {
+		return string_view(".");
+	}
+	
+	//A separator at the very start means the file is in the root directory
+	if (this->slashPos == 0) {
+		return string_view(this->path).substr(0, 1);
+	}
+	
+	return string_view(this->path).substr(0, this->slashPos);
+}
+
+string_view FilePath::extension() const
+{
+	if (this->dotPos == string::npos) {
+		return string_view();
+	}
+	
+	return string_view(this->path).substr(this->dotPos + 1);
+}
+
+string_view FilePath::stripExtension() const {
+	return string_view(this->path).substr(0, this->dotPos);
+}
+
+string_view FilePath::stem() const
+{
+	size_t start = (this->slashPos != string::npos) ? this->slashPos + 1 : 0;
+	size_t end   = (this->dotPos   != string::npos) ? this->dotPos       : this->path.length();
+	return string_view(this->path).substr(start, end - start);
+}
+
+FilePath& FilePath::append(string_view component)
+{
+	//Strip any leading separators from the component, since we supply our own
+	size_t skip = component.find_first_not_of("\\/");
+	component = (skip != string_view::npos) ? component.substr(skip) : string_view();
+	
+	//Insert a separator unless the path is empty or already ends with one
+	if (!this->path.empty() && this->slashPos != this->path.length() - 1) {
+		this->path += '/';
+	}
+	
+	this->path.append(component.data(), component.length());
+	this->parse();
+	return *this;
+}
+
+FilePath& FilePath::replaceExtension(string_view newExtension)
+{
+	//Truncate the existing extension (if any) and append the new one in place
+	if (this->dotPos != string::npos) {
+		this->path.resize(this->dotPos);
+	}
+	
+	this->dotPos = this->path.length();
+	this->path.reserve(this->path.length() + newExtension.length() + 1);
+	this->path += '.';
+	this->path.append(newExtension.data(), newExtension.length());
+	return *this;
+}
+
+FilePath FilePath::withExtension(string_view newExtension) const
+{
+	FilePath copy(*this);
+	copy.replaceExtension(newExtension);
+	return copy;
+}
+
+void FilePath::parse()
+{
+	//Locate the last separator, and then the last period after it
+	this->slashPos = this->path.find_last_of("\\/");
+	this->dotPos   = this->path.find_last_of('.');
+	if (this->dotPos != string::npos && this->slashPos != string::npos && this->dotPos < this->slashPos) {
+		this->dotPos = string::npos;
+	}
+}
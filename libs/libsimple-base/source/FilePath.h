@@ -0,0 +1,93 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  File Path Class
+//
+//  Stores a file path and the offsets of its last separator and extension
+//  period, which are located once upon construction. The basename, dirname
+//  and extension queries then return views into the stored path rather
+//  than allocating new strings the way the free functions do.
+//
+//  Unlike strip_extension() and get_extension(), the extension is only
+//  ever looked for in the final path component, matching the behaviour of
+//  replace_extension(). A path without an extension has an empty one.
+//
+//  Views returned by the query methods are invalidated by any method that
+//  modifies the path.
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _LIB_SIMPLE_BASE_FILE_PATH_H
+#define _LIB_SIMPLE_BASE_FILE_PATH_H
+
+#include <string>
+#include <string_view>
+using std::string;
+using std::string_view;
+
+class FilePath
+{
+	public:
+		FilePath();
+		FilePath(const string& path);
+		FilePath(const char* path);
+		
+		//Retrieves the full path (also usable anywhere the free functions expect a string)
+		const string& str() const { return this->path; }
+		operator const string&() const { return this->path; }
+		
+		//Everything after the last separator (equivalent to basename())
+		string_view basename() const;
+		
+		//Everything before the last separator, "." if there is none, "/" for the root (equivalent to dirname())
+		string_view dirname() const;
+		
+		//The extension, without the period (empty if the filename has no extension)
+		string_view extension() const;
+		
+		//The full path with the extension (and its period) removed
+		string_view stripExtension() const;
+		
+		//The filename with the extension (and its period) removed
+		string_view stem() const;
+		
+		//Determines whether the filename has an extension
+		bool hasExtension() const { return (this->dotPos != string::npos); }
+		
+		//Appends a path component, inserting a separator if needed
+		FilePath& append(string_view component);
+		
+		//Replaces the extension, or appends one if the filename has none (equivalent to replace_extension())
+		FilePath& replaceExtension(string_view newExtension);
+		
+		//Non-modifying version of replaceExtension()
+		FilePath withExtension(string_view newExtension) const;
+	
+	private:
+		//Locates the last separator and extension period
+		void parse();
+		
+		string path;
+		size_t slashPos;
+		size_t dotPos;
+};
+
+#endif
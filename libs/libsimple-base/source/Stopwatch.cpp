@@ -0,0 +1,169 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  Stopwatch
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "Stopwatch.h"
+#include "time.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#include <cpuid.h>
+	#include <x86intrin.h>
+	#define STOPWATCH_HAVE_TSC
+#endif
+
+//The length of the interval over which the TSC is calibrated
+#define TSC_CALIBRATION_NANOSECONDS 10000000
+
+//Determines the number of nanoseconds per tick of the TSC, or zero if the TSC cannot be used as a clock
+static double calibrate_timestamp_counter()
+{
+	#ifdef STOPWATCH_HAVE_TSC
+	
+	//The TSC is only usable as a clock if it ticks at a constant rate regardless of frequency scaling and sleep states
+	unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+	if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1 << 8))) {
+		return 0.0;
+	}
+	
+	int64_t startTime = nanotime();
+	uint64_t startTicks = __rdtsc();
+	int64_t endTime = startTime;
+	while (endTime - startTime < TSC_CALIBRATION_NANOSECONDS) {
+		endTime = nanotime();
+	}
+	
+	uint64_t endTicks = __rdtsc();
+	return (endTicks > startTicks) ? (double)(endTime - startTime) / (double)(endTicks - startTicks) : 0.0;
+	
+	#else
+	return 0.0;
+	#endif
+}
+
+//Retrieves the calibrated period of the TSC (calibrating it on the first call)
+static double timestamp_counter_period()
+{
+	static double period = calibrate_timestamp_counter();
+	return period;
+}
+
+Stopwatch::Stopwatch(ClockSource source, bool startRunning)
+{
+	this->clockSource = source;
+	this->nanosecondsPerTick = 1.0;
+	if (source == TimestampCounter)
+	{
+		this->nanosecondsPerTick = timestamp_counter_period();
+		if (this->nanosecondsPerTick == 0.0)
+		{
+			this->clockSource = MonotonicClock;
+			this->nanosecondsPerTick = 1.0;
+		}
+	}
+	
+	this->reset();
+	if (startRunning) {
+		this->start();
+	}
+}
+
+void Stopwatch::start()
+{
+	this->reset();
+	this->running = true;
+	this->startReading = this->read();
+}
+
+void Stopwatch::stop()
+{
+	if (this->running)
+	{
+		this->accumulated += this->toNanoseconds(this->read() - this->startReading);
+		this->running = false;
+	}
+}
+
+void Stopwatch::resume()
+{
+	if (!this->running)
+	{
+		this->running = true;
+		this->startReading = this->read();
+	}
+}
+
+void Stopwatch::reset()
+{
+	this->running = false;
+	this->startReading = 0;
+	this->accumulated = 0;
+	this->lastLapElapsed = 0;
+	this->lapDurations.clear();
+}
+
+int64_t Stopwatch::elapsed() const
+{
+	if (this->running) {
+		return this->accumulated + this->toNanoseconds(this->read() - this->startReading);
+	}
+	
+	return this->accumulated;
+}
+
+int64_t Stopwatch::split() const {
+	return this->elapsed() - this->lastLapElapsed;
+}
+
+int64_t Stopwatch::lap()
+{
+	int64_t now = this->elapsed();
+	int64_t duration = now - this->lastLapElapsed;
+	this->lastLapElapsed = now;
+	this->lapDurations.push_back(duration);
+	return duration;
+}
+
+bool Stopwatch::timestampCounterAvailable() {
+	return timestamp_counter_period() != 0.0;
+}
+
+int64_t Stopwatch::read() const
+{
+	#ifdef STOPWATCH_HAVE_TSC
+	if (this->clockSource == TimestampCounter) {
+		return (int64_t)__rdtsc();
+	}
+	#endif
+	
+	return nanotime();
+}
+
+int64_t Stopwatch::toNanoseconds(int64_t readingDiff) const
+{
+	if (this->clockSource == TimestampCounter) {
+		return (int64_t)((double)readingDiff * this->nanosecondsPerTick);
+	}
+	
+	return readingDiff;
+}
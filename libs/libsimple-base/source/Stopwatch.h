@@ -0,0 +1,109 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  Stopwatch
+//
+//  Measures intervals in integer nanoseconds using a monotonic clock (which,
+//  unlike microtime(), is unaffected by changes to the system time), with
+//  support for pausing and for recording laps.
+//
+//  The elapsed time is the total time spent running since the stopwatch was
+//  last started, a lap is the running time since the previous lap (or since
+//  the stopwatch was started), and a split is the running time since the
+//  previous lap without recording a new one.
+//
+//  Under x86 processors with an invariant timestamp counter, the TSC can be
+//  used as the clock source instead, which avoids the (small) overhead of
+//  the system call interface. The TSC is calibrated against the monotonic
+//  clock once per process, which takes around ten milliseconds. If the TSC
+//  is unavailable, the monotonic clock is used regardless.
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _LIB_SIMPLE_BASE_STOPWATCH_H
+#define _LIB_SIMPLE_BASE_STOPWATCH_H
+
+#include <stdint.h>
+#include <vector>
+using std::vector;
+
+class Stopwatch
+{
+	public:
+		enum ClockSource
+		{
+			MonotonicClock,
+			TimestampCounter
+		};
+		
+		//Creates a stopwatch using the specified clock source, which starts running immediately unless specified otherwise
+		Stopwatch(ClockSource source = MonotonicClock, bool startRunning = true);
+		
+		//The clock source in use (which is the monotonic clock if the TSC was requested but is unavailable)
+		ClockSource source() const { return this->clockSource; }
+		
+		//Determines if the stopwatch is running
+		bool isRunning() const { return this->running; }
+		
+		//Resets the elapsed time, clears all recorded laps and starts the stopwatch
+		void start();
+		
+		//Pauses the stopwatch (time spent stopped is not counted)
+		void stop();
+		
+		//Resumes the stopwatch after it was stopped, without resetting the elapsed time
+		void resume();
+		
+		//Stops the stopwatch and resets the elapsed time and recorded laps
+		void reset();
+		
+		//The total running time in nanoseconds
+		int64_t elapsed() const;
+		
+		//The running time in nanoseconds since the previous lap, without recording a lap
+		int64_t split() const;
+		
+		//Records a lap, returning its duration in nanoseconds
+		int64_t lap();
+		
+		//The durations of all recorded laps, in nanoseconds
+		const vector<int64_t>& laps() const { return this->lapDurations; }
+		
+		//Determines if the timestamp counter can be used as a clock source
+		static bool timestampCounterAvailable();
+	
+	private:
+		//Reads the current value of the clock source, in its native units
+		int64_t read() const;
+		
+		//Converts a difference between two readings into nanoseconds
+		int64_t toNanoseconds(int64_t readingDiff) const;
+		
+		ClockSource clockSource;
+		double nanosecondsPerTick;
+		bool running;
+		int64_t startReading;
+		int64_t accumulated;
+		int64_t lastLapElapsed;
+		vector<int64_t> lapDurations;
+};
+
+#endif
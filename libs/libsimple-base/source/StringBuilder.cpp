@@ -0,0 +1,144 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  String Builder Class
+//
+//  Accumulates string output into a single buffer that is reserved up front
+//  from a size estimate. Slices, characters, integers and hex bytes are
+//  appended directly into the buffer without creating temporaries.
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "StringBuilder.h"
+#include "file_manipulation.h"
+
+const char StringBuilder::hexDigits[17] = "0123456789abcdef";
+
+StringBuilder::StringBuilder(size_t sizeEstimate)
+{
+	this->fd          = -1;
+	this->chunkSize   = 0;
+	this->writeFailed = false;
+	this->buffer.reserve(sizeEstimate);
+}
+
+StringBuilder::StringBuilder(int fd, size_t chunkSize)
+{
+	this->fd          = fd;
+	this->chunkSize   = chunkSize;
+	this->writeFailed = false;
+	
+	//Leave some headroom so that the final append before a flush doesn't trigger a reallocation
+	this->buffer.reserve(chunkSize + (chunkSize / 8));
+}
+
+StringBuilder::~StringBuilder()
+{
+	if (this->fd != -1) {
+		this->flush();
+	}
+}
+
+void StringBuilder::reserve(size_t additional) {
+	this->buffer.reserve(this->buffer.length() + additional);
+}
+
+StringBuilder& StringBuilder::append(string_view s) {
+	return this->append(s.data(), s.length());
+}
+
+StringBuilder& StringBuilder::append(const char* data, size_t length)
+{
+	this->buffer.append(data, length);
+	this->flushIfFull();
+	return *this;
+}
+
+StringBuilder& StringBuilder::append(char c)
+{
+	this->buffer.push_back(c);
+	this->flushIfFull();
+	return *this;
+}
+
+StringBuilder& StringBuilder::append(size_t count, char c)
+{
+	this->buffer.append(count, c);
+	this->flushIfFull();
+	return *this;
+}
+
+StringBuilder& StringBuilder::appendInt(int64_t value)
+{
+	//Negate using unsigned arithmetic so that the minimum value doesn't overflow
+	if (value < 0)
+	{
+		this->buffer.push_back('-');
+		return this->appendUInt(0 - (uint64_t)value);
+	}
+	
+	return this->appendUInt((uint64_t)value);
+}
+
+StringBuilder& StringBuilder::appendUInt(uint64_t value)
+{
+	//Generate the digits in reverse order into a local buffer (20 digits is enough for any 64-bit value)
+	char digits[20];
+	char* end = digits + sizeof(digits);
+	char* pos = end;
+	do
+	{
+		*--pos = (char)('0' + (value % 10));
+		value /= 10;
+	}
+	while (value != 0);
+	
+	return this->append(pos, end - pos);
+}
+
+StringBuilder& StringBuilder::appendHexByte(unsigned char byte, bool prefix)
+{
+	char hex[4] = { '0', 'x', hexDigits[byte >> 4], hexDigits[byte & 0x0f] };
+	return (prefix) ? this->append(hex, 4) : this->append(hex + 2, 2);
+}
+
+bool StringBuilder::flush()
+{
+	//Nothing to do when building in memory
+	if (this->fd == -1) {
+		return true;
+	}
+	
+	if (!write_all(this->fd, this->buffer.data(), this->buffer.length())) {
+		this->writeFailed = true;
+	}
+	
+	//Discard the buffered data (keeping the allocated capacity for the next chunk)
+	this->buffer.clear();
+	return !this->writeFailed;
+}
+
+string StringBuilder::release()
+{
+	string result;
+	result.swap(this->buffer);
+	return result;
+}
@@ -0,0 +1,107 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  String Builder Class
+//
+//  Accumulates string output into a single buffer that is reserved up front
+//  from a size estimate. Slices, characters, integers and hex bytes are
+//  appended directly into the buffer without creating temporaries.
+//
+//  When constructed with a file descriptor, the buffer is written out each
+//  time it reaches the specified chunk size, so that arbitrarily large output
+//  can be generated using a fixed amount of memory. Any remaining data is
+//  written out by flush() or by the destructor.
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _LIB_SIMPLE_BASE_STRING_BUILDER_H
+#define _LIB_SIMPLE_BASE_STRING_BUILDER_H
+
+#include <stdint.h>
+#include <string>
+#include <string_view>
+using std::string;
+using std::string_view;
+
+class StringBuilder
+{
+	public:
+		//Creates an in-memory builder, reserving space for the estimated output size
+		StringBuilder(size_t sizeEstimate = 0);
+		
+		//Creates a builder that writes its contents to the supplied file descriptor every chunkSize bytes
+		StringBuilder(int fd, size_t chunkSize);
+		
+		//Flushes any remaining data when writing to a file descriptor
+		~StringBuilder();
+		
+		//Reserves space for at least the specified number of additional bytes
+		void reserve(size_t additional);
+		
+		//Append functions
+		StringBuilder& append(string_view s);
+		StringBuilder& append(const char* data, size_t length);
+		StringBuilder& append(char c);
+		StringBuilder& append(size_t count, char c);
+		StringBuilder& appendInt(int64_t value);
+		StringBuilder& appendUInt(uint64_t value);
+		StringBuilder& appendHexByte(unsigned char byte, bool prefix = false);
+		
+		//Writes the buffered data to the file descriptor, returning false if writing failed
+		bool flush();
+		
+		//Determines whether any write to the file descriptor has failed
+		bool failed() const { return this->writeFailed; }
+		
+		//Accessors for the buffered data (only the unflushed data when writing to a file descriptor)
+		size_t length() const { return this->buffer.length(); }
+		string_view view() const { return this->buffer; }
+		const string& str() const { return this->buffer; }
+		
+		//Moves the buffered data out of the builder, leaving it empty
+		string release();
+		
+		//Discards the buffered data without writing it
+		void clear() { this->buffer.clear(); }
+		
+		//Lowercase hexadecimal digits
+		static const char hexDigits[17];
+	
+	private:
+		//Copying a builder that writes to a file descriptor would result in duplicate output
+		StringBuilder(const StringBuilder& other);
+		StringBuilder& operator=(const StringBuilder& other);
+		
+		//Flushes the buffer if we are writing to a file descriptor and have reached the chunk size
+		void flushIfFull()
+		{
+			if (this->fd != -1 && this->buffer.length() >= this->chunkSize) {
+				this->flush();
+			}
+		}
+		
+		string buffer;
+		int fd;
+		size_t chunkSize;
+		bool writeFailed;
+};
+
+#endif
@@ -46,6 +46,7 @@
 #include "maths.h"
 #include "multiple_input_files.h"
 #include "pointer_manipulation.h"
+#include "profiling.h"
 #include "random.h"
 #include "string_manipulation.h"
 #include "time.h"
@@ -53,6 +54,16 @@
 //Include all of the base classes
 #include "StartupArgsParser.h"
 #include "DynamicLibrary.h"
+#include "FilePath.h"
+#include "FileInfo.h"
+#include "AsyncIO.h"
+#include "DirectoryWalker.h"
+#include "DirectoryWatcher.h"
+#include "Stopwatch.h"
+#include "DateFormatter.h"
+#include "BinaryReader.h"
+#include "BinaryWriter.h"
+#include "StringBuilder.h"
 
 //SHA-1 implementation Copyright (C) 1998, 2009 Paul E. Jones <paulej@packetizer.com>
 //From <http://www.packetizer.com/security/sha1>
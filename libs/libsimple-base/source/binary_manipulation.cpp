@@ -26,6 +26,7 @@
 //  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
 */
 #include "binary_manipulation.h"
+#include "StringBuilder.h"
 
 //The null-byte character
 static char nullbyte[1] = {0};
@@ -34,104 +35,68 @@ char* NULL_BYTE = (char*)nullbyte;
 //Function Definitions
 string byte_to_hex(char byte, bool prefix)
 {
-	//Temporary stringstream to hold the hex value
-	stringstream temp;
-	
-	//Insert the byte
-	temp << hex << (unsigned int)(unsigned char)byte;
-	
-	//Add any padding, if neccesary, and return the string
-	if (temp.str().length() < 2)
-	{
-		if (prefix) {
-			return "0x0" + temp.str();
-		}
-		else {
-			return "0" + temp.str();
-		}
-	}
-	else
-	{
-		if (prefix) {
-			return "0x" + temp.str();
-		}
-		else {
-			return temp.str();
-		}
-	}
+	//Look up the two hex digits directly, padding values under 0x10
+	StringBuilder temp(4);
+	temp.appendHexByte((unsigned char)byte, prefix);
+	return temp.release();
 }
 
 string bin_to_hex(const char* bytes, int length)
 {
-	//Temporary stringstream to hold the hex values
-	stringstream temp;
+	//Each byte becomes "0xXX " (5 characters)
+	StringBuilder temp((length > 0) ? length * 5 : 0);
 	
 	//Loop through each of the bytes
-	for (int i = 0; i < length; ++i)
-		temp << byte_to_hex(bytes[i]) << " ";
+	for (int i = 0; i < length; ++i) {
+		temp.appendHexByte((unsigned char)bytes[i], true).append(' ');
+	}
 	
-	//Return the contents of the stringstream
-	return temp.str();
+	//Return the hex values
+	return temp.release();
 }
 
 string hex(const char* bytes, int length)
 {
-	//Temporary stringstream to hold the hex values
-	stringstream temp;
+	//Each byte becomes two hex digits
+	StringBuilder temp((length > 0) ? length * 2 : 0);
 	
 	//Loop through each of the bytes
 	for (int i = 0; i < length; ++i) {
-		temp << byte_to_hex(bytes[i], false);
+		temp.appendHexByte((unsigned char)bytes[i]);
 	}
 	
-	//Return the contents of the stringstream
-	return temp.str();
+	//Return the hex values
+	return temp.release();
 }
 
 string bin_to_hex(string data)
 {
-	//Temporary stringstream to hold the hex values
-	stringstream temp;
-	temp << hex;
-	
-	//Calculate the hex of each of the bytes
-	//(we need to typecast to unsigned chars because negative values make no sense in this context)
-	for (size_t i = 0; i < data.length(); ++i)
-		temp << (int)(unsigned char)data[i];
-	
-	//Return the contents of the stringstream
-	return temp.str();
+	//Calculate the padded hex of each of the bytes
+	return hex(data.data(), data.length());
 }
 
 string bin_to_hex(unsigned int numbers[5])
 {
-	//Temporary stringstream to hold the hex values
-	stringstream temp;
-	
-	//Loop through the integers and convert each of their bytes to hex
-	for (int i = 0; i < 5; ++i)
-		temp << hex((char*)&numbers[i], sizeof(unsigned int));
-	
-	//Return the contents of the stringstream
-	return temp.str();
+	//Convert each of the integers' bytes to hex
+	return hex((const char*)numbers, 5 * sizeof(unsigned int));
 }
 
 string hex_with_ascii(const char* bytes, int length)
 {
-	//Temporary stringstream to hold the hex values
-	stringstream temp;
+	//Reserve enough space for the common case of mostly printable characters
+	StringBuilder temp((length > 0) ? length : 0);
 	
 	//Loop through the characters and convert them where neccessary
 	for (int i = 0; i < length; ++i)
 	{
 		if (bytes[i] <= 31 || bytes[i] >= 127) {
-			temp << byte_to_hex(bytes[i]);
+			temp.appendHexByte((unsigned char)bytes[i], true);
 		}
 		else {
-			temp << bytes[i];
+			temp.append(bytes[i]);
 		}
 	}
 	
-	//Return the contents of the stringstream
-	return temp.str();
+	//Return the converted string
+	return temp.release();
 }
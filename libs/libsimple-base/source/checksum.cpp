@@ -30,8 +30,10 @@
 
 #include "endianness.h"
 #include "binary_manipulation.h"
+#include "profiling.h"
 
 #include <stdexcept>
+#include <algorithm>
 
 //SHA-1 implementation by Paul E. Jones <paulej@packetizer.com>
 #include "sha1.h"
@@ -42,6 +44,15 @@
 //Function Definitions for CRC32
 uint32_t crc32(const string& path)
 {
+	PROFILE_ZONE("crc32 (file)");
+	
+	//Map the file, so the checksum can be computed without copying the data
+	MappedFile file(path, MappedFile::ReadOnly, MappedFile::Sequential);
+	if (file.isOpen()) {
+		return crc32(file);
+	}
+	
+	//Files that cannot be mapped (such as pipes and devices) are read in chunks
 	ifstream infile(path.c_str(), ios::binary);
 	if (infile.is_open())
 	{
@@ -72,11 +83,22 @@ uint32_t crc32(ifstream& infile)
 
 uint32_t crc32(const char *data, unsigned int length)
 {
+	PROFILE_ZONE("crc32 (buffer)");
 	crc_t crc = crc_init();
 	crc = crc_update(crc, (unsigned char*)data, length);
 	return (unsigned int)crc_finalize(crc);
 }
 
+uint32_t crc32(const MappedFile& file)
+{
+	crc_t crc = crc_init();
+	if (file.size() > 0) {
+		crc = crc_update(crc, (const unsigned char*)file.data(), file.size());
+	}
+	
+	return crc_finalize(crc);
+}
+
 uint32_t crc32_cumulative(unsigned int crc, char* data, unsigned int length)
 {
 	crc_t result = crc;
@@ -105,6 +127,8 @@ string sha1(const string& data)
 
 string sha1(const char *data, int length)
 {
+	PROFILE_ZONE("sha1 (buffer)");
+	
 	//The variables needed to use SHA-1
 	SHA1 sha;
 	unsigned int message_digest[5];
@@ -148,7 +172,17 @@ string sha1_file(const string& file)
 //Generate the raw binary SHA-1 checksum for a file
 void sha1_file_raw(const string& file, unsigned int checksum[5])
 {
-	//Attempt to open the specified file
+	PROFILE_ZONE("sha1 (file)");
+	
+	//Map the file, so the checksum can be computed without copying the data
+	MappedFile mapping(file, MappedFile::ReadOnly, MappedFile::Sequential);
+	if (mapping.isOpen())
+	{
+		sha1_file_raw(mapping, checksum);
+		return;
+	}
+	
+	//Files that cannot be mapped (such as pipes and devices) are read in chunks
 	ifstream infile(file.c_str(), ios::binary);
 	
 	//Check that the file opened properly
@@ -196,3 +230,28 @@ void sha1_file_raw(ifstream& infile, unsigned int checksum[5])
 		throw std::runtime_error("File stream not open!");
 	}
 }
+
+void sha1_file_raw(const MappedFile& file, unsigned int checksum[5])
+{
+	//Create a SHA-1 instance to calculate the checksum
+	SHA1 chcksum;
+	
+	//SHA1::Input() takes an unsigned length, so files over 4GiB are input in chunks
+	const size_t chunkSize = 1024 * 1024 * 1024;
+	for (size_t offset = 0; offset < file.size(); offset += chunkSize) {
+		chcksum.Input(file.data() + offset, (unsigned)std::min(chunkSize, file.size() - offset));
+	}
+	
+	//Calculate the checksum
+	if (!chcksum.Result(checksum)) {
+		throw "Couldn't compute checksum!";
+	}
+	
+	//SHA-1 is big-endian, so for little-endian systems, flip the endianness
+	if (endianness() == LITTLE_ENDIAN)
+	{
+		for (int i = 0; i < 5; ++i) {
+			checksum[i] = flipEndianness(checksum[i]);
+		}
+	}
+}
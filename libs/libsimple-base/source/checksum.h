@@ -33,6 +33,7 @@
 #include <fstream>
 #include <stdint.h>
 #include <cstring>
+#include "file_manipulation.h"
 using std::string;
 using std::ifstream;
 using std::ios;
@@ -41,6 +42,7 @@ using std::ios;
 uint32_t crc32(const string& path);
 uint32_t crc32(ifstream& infile);
 uint32_t crc32(const char *data, unsigned int length);
+uint32_t crc32(const MappedFile& file);
 
 //Use this for working with memory that you are writing to file as you go
 uint32_t crc32_cumulative(uint32_t crc, char* data = NULL, unsigned int length = 0);
@@ -54,5 +56,6 @@ string sha1_file(const string& file);      //Calculates the SHA-1 checksum of an
 //Generate the raw binary SHA-1 checksum for a file
 void sha1_file_raw(const string& file, unsigned int checksum[5]);
 void sha1_file_raw(ifstream& infile, unsigned int checksum[5]);
+void sha1_file_raw(const MappedFile& file, unsigned int checksum[5]);
 
 #endif
@@ -30,6 +30,11 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <cstring>
+
+#ifdef _MSC_VER
+	#include <stdlib.h>
+#endif
 
 #ifdef _WIN32
 	//We need to define these ourselves under windows
@@ -95,4 +100,68 @@ T toBigEndian(const T& original) {
 	return fromBigEndian(original);
 }
 
+//Compile-time detection of the host byte order (all Windows targets are little-endian)
+#if defined(_WIN32) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	#define HOST_IS_LITTLE_ENDIAN 1
+#else
+	#define HOST_IS_LITTLE_ENDIAN 0
+#endif
+
+//Reverses the byte order of an unsigned integer, compiling to a single bswap instruction where supported
+inline uint8_t byteSwap(uint8_t value) {
+	return value;
+}
+
+#ifdef _MSC_VER
+inline uint16_t byteSwap(uint16_t value) { return _byteswap_ushort(value); }
+inline uint32_t byteSwap(uint32_t value) { return _byteswap_ulong(value);  }
+inline uint64_t byteSwap(uint64_t value) { return _byteswap_uint64(value); }
+#else
+inline uint16_t byteSwap(uint16_t value) { return __builtin_bswap16(value); }
+inline uint32_t byteSwap(uint32_t value) { return __builtin_bswap32(value); }
+inline uint64_t byteSwap(uint64_t value) { return __builtin_bswap64(value); }
+#endif
+
+//Maps a datatype size to the unsigned integer type of the same size
+template <size_t N> struct UnsignedOfSize;
+template <> struct UnsignedOfSize<1> { typedef uint8_t  type; };
+template <> struct UnsignedOfSize<2> { typedef uint16_t type; };
+template <> struct UnsignedOfSize<4> { typedef uint32_t type; };
+template <> struct UnsignedOfSize<8> { typedef uint64_t type; };
+
+//Template functions for loading and storing integral and floating-point datatypes at unaligned addresses in a specific byte order.
+//Unlike the functions above, the byte order is resolved at compile time, so each compiles to a single load or store (plus a bswap if needed).
+template <typename T>
+T loadWithByteOrder(const void* source, bool littleEndian)
+{
+	typedef typename UnsignedOfSize<sizeof(T)>::type U;
+	U raw;
+	memcpy(&raw, source, sizeof(U));
+	if (littleEndian != (HOST_IS_LITTLE_ENDIAN == 1)) {
+		raw = byteSwap(raw);
+	}
+	
+	T value;
+	memcpy(&value, &raw, sizeof(T));
+	return value;
+}
+
+template <typename T>
+void storeWithByteOrder(void* dest, T value, bool littleEndian)
+{
+	typedef typename UnsignedOfSize<sizeof(T)>::type U;
+	U raw;
+	memcpy(&raw, &value, sizeof(T));
+	if (littleEndian != (HOST_IS_LITTLE_ENDIAN == 1)) {
+		raw = byteSwap(raw);
+	}
+	
+	memcpy(dest, &raw, sizeof(U));
+}
+
+template <typename T> T    loadLittleEndian (const void* source)  { return loadWithByteOrder<T>(source, true);  }
+template <typename T> T    loadBigEndian    (const void* source)  { return loadWithByteOrder<T>(source, false); }
+template <typename T> void storeLittleEndian(void* dest, T value) { storeWithByteOrder<T>(dest, value, true);   }
+template <typename T> void storeBigEndian   (void* dest, T value) { storeWithByteOrder<T>(dest, value, false);  }
+
 #endif
@@ -27,14 +27,30 @@
 */
 #include "environment.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <ctime>
+#include <deque>
 #include <iostream>
+#include <thread>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "DirectoryWalker.h"
+#include "profiling.h"
+#include "random.h"
 #include "string_manipulation.h"
+#include "StringBuilder.h"
 
 //Platform-specific includes
 #ifdef _WIN32
 	#include <windows.h>
+	#include <condition_variable>
+	#include <direct.h>
+	#include <functional>
+	#include <io.h>
+	#include <mutex>
 	
 	#ifdef _MSC_VER
 		#define popen _popen
@@ -46,8 +62,20 @@
 	#include <termios.h>    //Part of the POSIX library
 	#include <string.h>
 	#include <sys/wait.h>
+	#include <sys/resource.h>
+	#include <sys/syscall.h>
+	#include <poll.h>
+	#include <pthread.h>
+	#include <signal.h>
+	#include <spawn.h>
+	
+	//The environment of the current process, which is passed to child processes
+	extern char** environ;
 #endif
 
+//The size of the buffer used when reading from (and writing to) a child process's standard streams
+#define PIPE_BUFFER_SIZE 65536
+
 //Function Definitions
 string temp_dir(bool trailing_slash)
 {
@@ -74,54 +102,307 @@ string temp_dir(bool trailing_slash)
 		return temp;
 }
 
+//Reads everything from a descriptor, appending it to the output string. For regular files, the string is sized up front using the
+//remaining size of the file, and in all other cases its size is doubled as needed, with the data read directly into the string.
+//Returns false if a read fails.
+static bool read_descriptor(int fd, string& output)
+{
+	size_t filled = output.length();
+	size_t chunkSize = PIPE_BUFFER_SIZE;
+	
+	struct stat fileInfo;
+	if (fstat(fd, &fileInfo) == 0 && S_ISREG(fileInfo.st_mode))
+	{
+		int64_t offset = lseek(fd, 0, SEEK_CUR);
+		int64_t remaining = (int64_t)fileInfo.st_size - ((offset > 0) ? offset : 0);
+		if (remaining > 0) {
+			chunkSize = (size_t)remaining + 1;
+		}
+	}
+	
+	bool succeeded = true;
+	while (true)
+	{
+		//Ensure there is room to read the next chunk, doubling the size of the string if the chunk has been used up
+		if (filled == output.length()) {
+			output.resize(filled + std::max(chunkSize, filled));
+			chunkSize = PIPE_BUFFER_SIZE;
+		}
+		
+		int bytesRead = (int)read(fd, &output[filled], (unsigned int)std::min(output.length() - filled, (size_t)0x40000000));
+		if (bytesRead == -1 && errno == EINTR) {
+			continue;
+		}
+		else if (bytesRead <= 0)
+		{
+			succeeded = (bytesRead == 0);
+			break;
+		}
+		
+		filled += bytesRead;
+	}
+	
+	output.resize(filled);
+	return succeeded;
+}
+
 string capture_output(string command)
 {
 	return capture_output(command.c_str());
 }
 
-//This function derived from the excellent code example by Salem from <http://www.daniweb.com/forums/post654859.html#post654859>
 string capture_output(const char* command)
 {
-	//Stringstream to hold the output and a character array to use as a line buffer
-	stringstream output;
-	char buff[100];
+	string output;
+	capture_output(command, output);
+	return output;
+}
+
+bool capture_output(const string& command, string& output, int* exitCode)
+{
+	//Execute the command using the shell and read the output straight from the underlying descriptor
+	FILE* fp = popen(command.c_str(), "r");
+	if (fp == NULL) {
+		return false;
+	}
+	
+	bool succeeded = read_descriptor(fileno(fp), output);
+	int status = pclose(fp);
 	
-	//Execute the command and read the output, 100 characters at a time
-	FILE *fp = popen(command, "r");
-	if (fp)
+	if (exitCode != NULL)
 	{
-		while ( fgets( buff, sizeof buff, fp ) != NULL ) {
-			//Add the contents of the buffer to the overall output
-			output << buff;
-		}
-		pclose(fp);
+		#ifdef _WIN32
+		*exitCode = status;
+		#else
+		*exitCode = (WIFEXITED(status)) ? WEXITSTATUS(status) : -1;
+		#endif
 	}
 	
-	//Return the complete output
-	return output.str();
+	return succeeded && status != -1;
 }
 
-//Based on the function above, reads everything from stdin
 string read_entire_stdin()
 {
-	//Stringstream to hold the input and a character array to use as a line buffer
-	stringstream output;
-	char buff[100];
+	string output;
+	read_entire_stdin(output);
+	return output;
+}
+
+bool read_entire_stdin(string& output)
+{
+	#ifdef _WIN32
+	_setmode(_fileno(stdin), _O_BINARY);
+	#endif
 	
-	//Read stdin, 100 characters at a time
-	while ( fgets( buff, sizeof buff, stdin ) != NULL ) {
-		//Add the contents of the buffer to the overall output
-		output << buff;
+	return read_descriptor(fileno(stdin), output);
+}
+
+string_view read_stdin_chunk(vector<char>& buffer)
+{
+	#ifdef _WIN32
+	_setmode(_fileno(stdin), _O_BINARY);
+	#endif
+	
+	while (true)
+	{
+		int bytesRead = (int)read(fileno(stdin), buffer.data(), (unsigned int)buffer.size());
+		if (bytesRead == -1 && errno == EINTR) {
+			continue;
+		}
+		
+		return string_view(buffer.data(), (bytesRead > 0) ? bytesRead : 0);
+	}
+}
+
+//Generates a random suffix for a temporary file or directory name, using a generator for each thread
+//(so that threads never contend with each other, and names are unpredictable across processes)
+static string random_name_suffix()
+{
+	static thread_local RandomDataGenerator generator;
+	uint64_t value = generator.next();
+	
+	StringBuilder suffix(16);
+	for (int i = 0; i < 8; ++i) {
+		suffix.appendHexByte((unsigned char)(value >> (i * 8)));
 	}
 	
-	//Return the complete output
-	return output.str();
+	return suffix.release();
 }
 
 string generate_unique_filename()
 {
-	srand(time(NULL));
-	return temp_dir(true) + toString(time(0)) + toString(rand()) + toString(rand());
+	return temp_dir(true) + random_name_suffix();
+}
+
+//Removes a file or an empty directory
+static bool remove_path(const string& path, bool isDirectory)
+{
+	#ifdef _WIN32
+	return ((isDirectory) ? _rmdir(path.c_str()) : _unlink(path.c_str())) == 0;
+	#else
+	return ((isDirectory) ? rmdir(path.c_str()) : unlink(path.c_str())) == 0;
+	#endif
+}
+
+TempFile::TempFile(const string& directory, const string& prefix, bool anonymous)
+{
+	string parent = (directory.empty()) ? temp_dir() : directory;
+	this->fd = -1;
+	
+	//Under Linux, O_TMPFILE creates a file with no name at all, so there is nothing to collide with or to clean up
+	#ifdef O_TMPFILE
+	if (anonymous)
+	{
+		this->fd = open(parent.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+		if (this->fd != -1) {
+			return;
+		}
+	}
+	#endif
+	
+	//Otherwise, create a file with a random name, trying again with a new name if it already exists
+	for (int attempt = 0; attempt < 100 && this->fd == -1; ++attempt)
+	{
+		this->filePath = parent + "/" + prefix + random_name_suffix();
+		
+		#ifdef _WIN32
+		this->fd = _open(this->filePath.c_str(), _O_RDWR | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE);
+		#else
+		this->fd = open(this->filePath.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+		#endif
+		
+		if (this->fd == -1 && errno != EEXIST) {
+			break;
+		}
+	}
+	
+	if (this->fd == -1) {
+		this->filePath = "";
+	}
+}
+
+TempFile::~TempFile() {
+	this->remove();
+}
+
+bool TempFile::keep(const string& destination)
+{
+	if (this->fd == -1) {
+		return false;
+	}
+	
+	//Anonymous files are given a name by linking the descriptor into the filesystem
+	#ifdef O_TMPFILE
+	if (this->filePath.empty())
+	{
+		string procPath = "/proc/self/fd/" + toString(this->fd);
+		if (linkat(AT_FDCWD, procPath.c_str(), AT_FDCWD, destination.c_str(), AT_SYMLINK_FOLLOW) != 0) {
+			return false;
+		}
+		
+		this->filePath = destination;
+		close(this->fd);
+		this->fd = -1;
+		return true;
+	}
+	#endif
+	
+	#ifdef _WIN32
+	_close(this->fd);
+	this->fd = -1;
+	if (MoveFileExA(this->filePath.c_str(), destination.c_str(), MOVEFILE_REPLACE_EXISTING) == 0) {
+		return false;
+	}
+	#else
+	if (rename(this->filePath.c_str(), destination.c_str()) != 0) {
+		return false;
+	}
+	
+	close(this->fd);
+	this->fd = -1;
+	#endif
+	
+	this->filePath = destination;
+	return true;
+}
+
+void TempFile::remove()
+{
+	if (this->fd != -1)
+	{
+		#ifdef _WIN32
+		_close(this->fd);
+		#else
+		close(this->fd);
+		#endif
+		
+		if (!this->filePath.empty()) {
+			remove_path(this->filePath, false);
+		}
+		
+		this->fd = -1;
+		this->filePath = "";
+	}
+}
+
+TempDirectory::TempDirectory(const string& parent, const string& prefix)
+{
+	string parentDir = (parent.empty()) ? temp_dir() : parent;
+	for (int attempt = 0; attempt < 100; ++attempt)
+	{
+		this->dirPath = parentDir + "/" + prefix + random_name_suffix();
+		
+		#ifdef _WIN32
+		int result = _mkdir(this->dirPath.c_str());
+		#else
+		int result = mkdir(this->dirPath.c_str(), S_IRWXU);
+		#endif
+		
+		if (result == 0) {
+			return;
+		}
+		else if (errno != EEXIST) {
+			break;
+		}
+	}
+	
+	this->dirPath = "";
+}
+
+TempDirectory::~TempDirectory() {
+	this->remove();
+}
+
+void TempDirectory::keep() {
+	this->dirPath = "";
+}
+
+bool TempDirectory::remove()
+{
+	if (this->dirPath.empty()) {
+		return true;
+	}
+	
+	//Gather the contents of the directory, without following symlinks
+	vector< std::pair<string, bool> > entries;
+	WalkOptions options;
+	options.includeDirectories = true;
+	walk_directory(this->dirPath, [&entries](const WalkEntry& entry)
+	{
+		entries.push_back(std::make_pair(entry.path, entry.isDirectory));
+		return true;
+	}, options);
+	
+	//Remove the entries in reverse order of their paths, so that the contents of each directory are removed before the directory itself
+	std::sort(entries.begin(), entries.end());
+	bool succeeded = true;
+	for (vector< std::pair<string, bool> >::reverse_iterator entry = entries.rbegin(); entry != entries.rend(); ++entry) {
+		succeeded = remove_path(entry->first, entry->second) && succeeded;
+	}
+	
+	succeeded = remove_path(this->dirPath, true) && succeeded;
+	this->dirPath = "";
+	return succeeded;
 }
 
 //Wraps around getenv to support std::strings
@@ -136,11 +417,44 @@ string get_env(const string& var)
 	}
 }
 
+//Creates an output callback that appends each chunk to the destination string
+static OutputCallback append_to(string& destination)
+{
+	return [&destination](const char* data, size_t length)
+	{
+		destination.append(data, length);
+		return true;
+	};
+}
+
 //Creating child processes is a very different affair under Windows when compared to POSIX-compliant operating systems
 #ifdef _WIN32
 	
-	int executeProcessWithPipes(const std::string& command, const string& writeThisToStdIn, string& thisReceivesStdOut, string& thisReceivesStdErr, bool combineStdErrWithStdOut)
+	//Reads from a pipe until the write end is closed, passing each chunk to the callback (while holding the lock, so that the
+	//callbacks for the two output pipes are never invoked concurrently). If the callback returns false, the process is terminated.
+	static void read_pipe(HANDLE pipe, const OutputCallback& callback, std::mutex& callbackLock, bool& stopped, HANDLE process)
 	{
+		vector<char> buffer(PIPE_BUFFER_SIZE);
+		DWORD bytesRead = 0;
+		while (ReadFile(pipe, buffer.data(), (DWORD)buffer.size(), &bytesRead, NULL) && bytesRead)
+		{
+			std::lock_guard<std::mutex> lock(callbackLock);
+			if (!stopped && callback && !callback(buffer.data(), (size_t)bytesRead))
+			{
+				stopped = true;
+				TerminateProcess(process, (UINT)-1);
+			}
+		}
+	}
+	
+	int executeProcessWithCallbacks(const std::string& command, const string& writeThisToStdIn, const OutputCallback& onStdOut, const OutputCallback& onStdErr, bool combineStdErrWithStdOut, int timeoutMs, bool* timedOut)
+	{
+		PROFILE_ZONE_DETAIL("executeProcess", command.c_str());
+		
+		if (timedOut != NULL) {
+			*timedOut = false;
+		}
+		
 		//---- Stage 1 - Pipe Creation ----
 		
 		//We need to create a SECURITY_ATTRIBUTES instance with bInheritHandle to true for creating inheritable pipe handles 
@@ -199,16 +513,6 @@ string get_env(const string& var)
 		//Create the process
 		if (CreateProcess(NULL, const_cast<char*>(command.c_str()), NULL, NULL, true, 0, NULL, NULL, &sInfo, &pInfo))
 		{
-			//Write the data to the child's stdin
-			if (writeThisToStdIn.length() > 0)
-			{
-				DWORD bytesWritten = 0;
-				WriteFile(stdInput[1], writeThisToStdIn.data(), (DWORD)(writeThisToStdIn.length()), &bytesWritten, NULL);
-			}
-			
-			//Close the write handle for the child's stdin
-			CloseHandle(stdInput[1]);
-			
 			//Close the read handle for the child's stdin
 			CloseHandle(stdInput[0]);
 			
@@ -216,27 +520,61 @@ string get_env(const string& var)
 			CloseHandle(stdOutput[1]);
 			CloseHandle(stdError[1]);
 			
-			//Read data from the child's stdout
-			char buffStdOut[100];
-			DWORD bytesReadStdOut = 0;
-			while (ReadFile(stdOutput[0], buffStdOut, sizeof buffStdOut, &bytesReadStdOut, NULL) && bytesReadStdOut) {
-				thisReceivesStdOut.append(buffStdOut, (size_t)bytesReadStdOut);
+			//Service each of the pipes on its own thread, so that the child can never block on one pipe while we are waiting on another
+			std::thread inputThread([&]()
+			{
+				size_t offset = 0;
+				DWORD bytesWritten = 0;
+				while (offset < writeThisToStdIn.length())
+				{
+					DWORD chunkSize = (DWORD)std::min(writeThisToStdIn.length() - offset, (size_t)PIPE_BUFFER_SIZE);
+					if (!WriteFile(stdInput[1], writeThisToStdIn.data() + offset, chunkSize, &bytesWritten, NULL)) {
+						break;
+					}
+					
+					offset += bytesWritten;
+				}
+				
+				//Close the write handle for the child's stdin
+				CloseHandle(stdInput[1]);
+			});
+			
+			std::mutex callbackLock;
+			bool stopped = false;
+			std::thread outputThread(read_pipe, stdOutput[0], std::cref(onStdOut), std::ref(callbackLock), std::ref(stopped), pInfo.hProcess);
+			std::thread errorThread(read_pipe, stdError[0], std::cref(onStdErr), std::ref(callbackLock), std::ref(stopped), pInfo.hProcess);
+			
+			//Wait for the child to complete, terminating it if the timeout expires
+			bool expired = false;
+			if (WaitForSingleObject(pInfo.hProcess, (timeoutMs >= 0) ? (DWORD)timeoutMs : INFINITE) == WAIT_TIMEOUT)
+			{
+				TerminateProcess(pInfo.hProcess, (UINT)-1);
+				WaitForSingleObject(pInfo.hProcess, INFINITE);
+				expired = true;
+			}
+			
+			bool killed = expired;
+			{
+				std::lock_guard<std::mutex> lock(callbackLock);
+				killed = killed || stopped;
 			}
 			
-			//Read data from the child's stderr
-			char buffStdErr[100];
-			DWORD bytesReadStdErr = 0;
-			while (ReadFile(stdError[0], buffStdErr, sizeof buffStdErr, &bytesReadStdErr, NULL) && bytesReadStdErr) {
-				thisReceivesStdErr.append(buffStdErr, (size_t)bytesReadStdErr);
+			if (killed)
+			{
+				//Any processes started by the child may still hold the pipes open, so we cancel any reads or writes in progress
+				CancelSynchronousIo(inputThread.native_handle());
+				CancelSynchronousIo(outputThread.native_handle());
+				CancelSynchronousIo(errorThread.native_handle());
 			}
 			
+			inputThread.join();
+			outputThread.join();
+			errorThread.join();
+			
 			//Close the read handles for the child's output pipes
 			CloseHandle(stdOutput[0]);
 			CloseHandle(stdError[0]);
 			
-			//Wait for the child to complete
-			WaitForSingleObject(pInfo.hProcess, INFINITE);
-			
 			//Retrieve the exit code of the child process
 			DWORD returnVal = -1;
 			GetExitCodeProcess(pInfo.hProcess, &returnVal);
@@ -245,33 +583,69 @@ string get_env(const string& var)
 			CloseHandle(pInfo.hProcess);
 			CloseHandle(pInfo.hThread);
 			
+			if (timedOut != NULL) {
+				*timedOut = expired;
+			}
+			
 			//Return the return code
-			return (int)returnVal;
+			return (killed) ? -1 : (int)returnVal;
 		}
 		
+		//Creating the process failed, so close the pipes
+		CloseHandle(stdInput[0]);
+		CloseHandle(stdInput[1]);
+		CloseHandle(stdOutput[0]);
+		CloseHandle(stdOutput[1]);
+		CloseHandle(stdError[0]);
+		CloseHandle(stdError[1]);
 		return -1;
 	}
 	
 #else
 
-	#define __MAX_ARGV_ARGS 255
+	static void set_descriptor_flag(int fd, int getCommand, int setCommand, int flag) {
+		fcntl(fd, setCommand, fcntl(fd, getCommand) | flag);
+	}
+	
+	//Creates a pipe whose descriptors are closed on exec, so that processes started concurrently by other threads do not
+	//inherit them (pipe2() sets the flag atomically, whereas setting it afterwards leaves a window in which a spawn can occur)
+	static int create_pipe(int descriptors[2])
+	{
+		#ifdef __linux__
+		return pipe2(descriptors, O_CLOEXEC);
+		#else
+		if (pipe(descriptors) == -1) {
+			return -1;
+		}
+		
+		set_descriptor_flag(descriptors[0], F_GETFD, F_SETFD, FD_CLOEXEC);
+		set_descriptor_flag(descriptors[1], F_GETFD, F_SETFD, FD_CLOEXEC);
+		return 0;
+		#endif
+	}
 	
-	int executeProcessWithPipes(const std::string& command, const string& writeThisToStdIn, string& thisReceivesStdOut, string& thisReceivesStdErr, bool combineStdErrWithStdOut)
+	//Creates the pipes for a child's standard streams and starts the child, storing our (non-blocking) ends of the pipes
+	//for stdin, stdout and stderr in pipes. If stdOutDescriptor is not negative, the child's stdout is redirected to it
+	//instead of a pipe (and the descriptor for our end of the stdout pipe is -1). Returns the PID of the child, or -1 if
+	//it could not be started.
+	static pid_t spawn_with_pipes(const string& command, bool combineStdErrWithStdOut, int stdOutDescriptor, struct pollfd pipes[3])
 	{
+		PROFILE_ZONE_DETAIL("spawnProcess", command.c_str());
+		
 		//Create the pipes
 		int pStdIn[2];
 		int pStdOut[2];
 		int pStdErr[2];
 		
-		//If we are unable to create a pipe, make sure we close any that are already open
-		if (pipe(pStdIn) == -1) return -1;
-		if (pipe(pStdOut) == -1)
+		//If we are unable to create a pipe, make sure we close any that are already open (dup2() clears the close-on-exec flag for the child's copies)
+		if (create_pipe(pStdIn) == -1) return -1;
+		if (create_pipe(pStdOut) == -1)
 		{
 			close(pStdIn[0]);
 			close(pStdIn[1]);
 			return -1;
 		}
-		if (pipe(pStdErr) == -1)
+		if (create_pipe(pStdErr) == -1)
 		{
 			close(pStdIn[0]);
 			close(pStdIn[1]);
@@ -280,111 +654,623 @@ string get_env(const string& var)
 			return -1;
 		}
 		
-		//Fork
-		pid_t childPid = fork();
-		if (childPid == -1)
+		//Break the command into argv components
+		vector<string> argvStructure = argv_from_string(command);
+		vector<char*> argv;
+		for (vector<string>::iterator currArg = argvStructure.begin(); currArg != argvStructure.end(); ++currArg) {
+			argv.push_back(const_cast<char*>(currArg->c_str()));
+		}
+		argv.push_back(NULL);
+		
+		//Redirect the child's standard streams to the pipes (the original descriptors are closed on exec, so only the standard streams remain)
+		posix_spawn_file_actions_t fileActions;
+		posix_spawn_file_actions_init(&fileActions);
+		posix_spawn_file_actions_adddup2(&fileActions, pStdIn[0],  STDIN_FILENO);
+		int stdOutTarget = (stdOutDescriptor >= 0) ? stdOutDescriptor : pStdOut[1];
+		posix_spawn_file_actions_adddup2(&fileActions, stdOutTarget, STDOUT_FILENO);
+		posix_spawn_file_actions_adddup2(&fileActions, (combineStdErrWithStdOut) ? stdOutTarget : pStdErr[1], STDERR_FILENO);
+		
+		//Unlike fork(), posix_spawn() does not copy our page tables, so the cost of spawning does not grow with our memory usage
+		//(glibc implements it using clone() with CLONE_VM and CLONE_VFORK, and reports failures to execute the command as errors)
+		pid_t childPid = -1;
+		int spawnResult = (argv[0] != NULL) ? posix_spawnp(&childPid, argv[0], &fileActions, NULL, argv.data(), environ) : EINVAL;
+		posix_spawn_file_actions_destroy(&fileActions);
+		
+		//Close the ends of the pipes that we won't be using
+		close(pStdIn[0]);
+		close(pStdOut[1]);
+		close(pStdErr[1]);
+		
+		if (spawnResult != 0)
 		{
-			//Failed to fork, close the pipes
-			close(pStdIn[0]);
+			//Failed to start the child process, close the remaining ends of the pipes
 			close(pStdIn[1]);
 			close(pStdOut[0]);
-			close(pStdOut[1]);
 			close(pStdErr[0]);
-			close(pStdErr[1]);
 			return -1;
 		}
-		else if (childPid == 0)
+		
+		//If the child's stdout was redirected elsewhere, the stdout pipe is not needed
+		if (stdOutDescriptor >= 0)
 		{
-			//Child process
-			
-			//Close the ends of the pipes that we won't be using
-			close(pStdIn[1]);
 			close(pStdOut[0]);
-			close(pStdErr[0]);
-			
-			//Redirect our standard streams to the pipes
-			dup2(pStdIn[0],  fileno(stdin));
-			dup2(pStdOut[1], fileno(stdout));
+			pStdOut[0] = -1;
+		}
+		
+		pipes[0].fd     = pStdIn[1];
+		pipes[0].events = POLLOUT;
+		pipes[1].fd     = pStdOut[0];
+		pipes[1].events = POLLIN;
+		pipes[2].fd     = pStdErr[0];
+		pipes[2].events = POLLIN;
+		for (int i = 0; i < 3; ++i)
+		{
+			pipes[i].revents = 0;
+			if (pipes[i].fd != -1) {
+				set_descriptor_flag(pipes[i].fd, F_GETFL, F_SETFL, O_NONBLOCK);
+			}
+		}
+		
+		return childPid;
+	}
+	
+	//Services whichever of a child's pipes poll() reported as ready, writing as much of the remaining input as the pipe will accept
+	//and passing any available output to the callbacks. Each pipe is closed (and its descriptor set to -1) once it is finished.
+	//Returns false if a callback asked for the child to be stopped.
+	static bool service_pipes(struct pollfd pipes[3], const string& input, size_t& bytesWritten, const OutputCallback* callbacks[3], vector<char>& buffer)
+	{
+		//Close stdin once everything is written (or the child closes its end), so that the child sees EOF
+		if (pipes[0].fd != -1 && pipes[0].revents != 0)
+		{
+			ssize_t result = write(pipes[0].fd, input.data() + bytesWritten, input.length() - bytesWritten);
+			if (result > 0) {
+				bytesWritten += result;
+			}
 			
-			//Check if we are redirecting stderr to stdout
-			if (combineStdErrWithStdOut) {
-				dup2(pStdOut[1], fileno(stderr));
+			if (bytesWritten == input.length() || (result == -1 && errno != EAGAIN && errno != EINTR))
+			{
+				close(pipes[0].fd);
+				pipes[0].fd = -1;
 			}
-			else {
-				dup2(pStdErr[1], fileno(stderr));
+		}
+		
+		//Read whatever output is available, closing each pipe once the child closes its end
+		for (int i = 1; i < 3; ++i)
+		{
+			if (pipes[i].fd != -1 && pipes[i].revents != 0)
+			{
+				ssize_t result = read(pipes[i].fd, buffer.data(), buffer.size());
+				if (result > 0)
+				{
+					if (*callbacks[i] && !(*callbacks[i])(buffer.data(), (size_t)result)) {
+						return false;
+					}
+				}
+				else if (result == 0 || (errno != EAGAIN && errno != EINTR))
+				{
+					close(pipes[i].fd);
+					pipes[i].fd = -1;
+				}
+			}
+		}
+		
+		return true;
+	}
+	
+	//Writing to a child's stdin after it has exited raises SIGPIPE, so we block the signal while servicing pipes.
+	//Returns true if a SIGPIPE was already pending before the signal was blocked.
+	static bool block_sigpipe(sigset_t* previousMask)
+	{
+		sigset_t sigpipeMask;
+		sigset_t pendingSignals;
+		sigemptyset(&sigpipeMask);
+		sigaddset(&sigpipeMask, SIGPIPE);
+		pthread_sigmask(SIG_BLOCK, &sigpipeMask, previousMask);
+		sigpending(&pendingSignals);
+		return sigismember(&pendingSignals, SIGPIPE);
+	}
+	
+	//Discards any SIGPIPE raised by our writes before restoring the signal mask
+	static void restore_sigpipe(const sigset_t& previousMask, bool alreadyPending)
+	{
+		sigset_t sigpipeMask;
+		sigset_t pendingSignals;
+		sigemptyset(&sigpipeMask);
+		sigaddset(&sigpipeMask, SIGPIPE);
+		sigpending(&pendingSignals);
+		if (!alreadyPending && sigismember(&pendingSignals, SIGPIPE))
+		{
+			int received = 0;
+			sigwait(&sigpipeMask, &received);
+		}
+		
+		pthread_sigmask(SIG_SETMASK, &previousMask, NULL);
+	}
+	
+	//Runs a child process, passing its output to the callbacks (see executeProcessWithCallbacks() and executeProcessToDescriptor())
+	static int execute_process(const std::string& command, const string& writeThisToStdIn, const OutputCallback& onStdOut, const OutputCallback& onStdErr, bool combineStdErrWithStdOut, int stdOutDescriptor, int timeoutMs, bool* timedOut)
+	{
+		PROFILE_ZONE_DETAIL("executeProcess", command.c_str());
+		
+		if (timedOut != NULL) {
+			*timedOut = false;
+		}
+		
+		//Start the child process
+		struct pollfd pipes[3];
+		pid_t childPid = spawn_with_pipes(command, combineStdErrWithStdOut, stdOutDescriptor, pipes);
+		if (childPid == -1) {
+			return -1;
+		}
+		
+		//Service all three pipes at once, so that the child can never block on one pipe while we are waiting on another
+		sigset_t previousMask;
+		bool sigpipeAlreadyPending = block_sigpipe(&previousMask);
+		const OutputCallback* callbacks[3] = {NULL, &onStdOut, &onStdErr};
+		vector<char> buffer(PIPE_BUFFER_SIZE);
+		size_t bytesWritten = 0;
+		bool killed = false;
+		bool expired = false;
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+		while (pipes[0].fd != -1 || pipes[1].fd != -1 || pipes[2].fd != -1)
+		{
+			//If a timeout was specified, determine how much longer we can wait
+			int waitMs = -1;
+			if (timeoutMs >= 0)
+			{
+				int64_t remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+				if (remaining <= 0)
+				{
+					kill(childPid, SIGKILL);
+					killed = true;
+					expired = true;
+					break;
+				}
+				
+				waitMs = (int)remaining;
 			}
 			
-			//We can now close the other ends of the pipes - the standard streams are aliases to them now
-			close(pStdIn[0]);
-			close(pStdOut[1]);
-			close(pStdErr[1]);
+			int numReady = poll(pipes, 3, waitMs);
+			if (numReady == -1 && errno != EINTR) {
+				break;
+			}
+			else if (numReady <= 0) {
+				continue;
+			}
 			
-			//Break the command into argv components
-			vector<string> argvStructure = argv_from_string(command);
-			char* argv[__MAX_ARGV_ARGS];
-			unsigned int argvIndex = 0;
-			for (; argvIndex < (__MAX_ARGV_ARGS - 1) && argvIndex < argvStructure.size(); ++argvIndex) {
-				argv[argvIndex] = const_cast<char*>(argvStructure[argvIndex].c_str());
+			if (!service_pipes(pipes, writeThisToStdIn, bytesWritten, callbacks, buffer))
+			{
+				kill(childPid, SIGKILL);
+				killed = true;
+				break;
 			}
-			argv[argvIndex] = NULL;
+		}
+		
+		//Close the remaining ends of the pipes
+		for (int i = 0; i < 3; ++i)
+		{
+			if (pipes[i].fd != -1) {
+				close(pipes[i].fd);
+			}
+		}
+		
+		restore_sigpipe(previousMask, sigpipeAlreadyPending);
+		
+		//The child may close or redirect its output and keep running, so keep enforcing the timeout until it exits
+		int status = 0;
+		bool reaped = false;
+		if (timeoutMs >= 0 && !killed)
+		{
+			//A pidfd becomes readable when the child exits, otherwise we poll for the child's exit
+			int pidfd = -1;
+			#ifdef SYS_pidfd_open
+			pidfd = (int)syscall(SYS_pidfd_open, childPid, 0);
+			#endif
 			
-			//Execute the command
-			execvp(argv[0], argv);
+			while (true)
+			{
+				pid_t waitResult = waitpid(childPid, &status, WNOHANG);
+				if (waitResult == childPid)
+				{
+					reaped = true;
+					break;
+				}
+				else if (waitResult == -1 && errno != EINTR) {
+					break;
+				}
+				
+				int64_t remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+				if (remaining <= 0)
+				{
+					kill(childPid, SIGKILL);
+					killed = true;
+					expired = true;
+					break;
+				}
+				
+				if (pidfd != -1)
+				{
+					struct pollfd exitDescriptor = {pidfd, POLLIN, 0};
+					poll(&exitDescriptor, 1, (int)remaining);
+				}
+				else {
+					std::this_thread::sleep_for(std::chrono::milliseconds(std::min<int64_t>(remaining, 10)));
+				}
+			}
 			
-			//If we reach this point, we failed to execute the command
-			exit(-1);
+			if (pidfd != -1) {
+				close(pidfd);
+			}
+		}
+		
+		//Wait for the child process to complete and retrieve the return code
+		int returnCode = -1;
+		if (!reaped) {
+			while (waitpid(childPid, &status, 0) == -1 && errno == EINTR) {}
 		}
-		else
+		
+		if (WIFEXITED(status) && !killed) {
+			returnCode = WEXITSTATUS(status);
+		}
+		
+		if (timedOut != NULL) {
+			*timedOut = expired;
+		}
+		
+		//Return the return code
+		return returnCode;
+	}
+	
+	int executeProcessWithCallbacks(const std::string& command, const string& writeThisToStdIn, const OutputCallback& onStdOut, const OutputCallback& onStdErr, bool combineStdErrWithStdOut, int timeoutMs, bool* timedOut) {
+		return execute_process(command, writeThisToStdIn, onStdOut, onStdErr, combineStdErrWithStdOut, -1, timeoutMs, timedOut);
+	}
+	
+	int executeProcessToDescriptor(const std::string& command, const string& writeThisToStdIn, int stdOutDescriptor, const OutputCallback& onStdErr, int timeoutMs, bool* timedOut) {
+		return execute_process(command, writeThisToStdIn, OutputCallback(), onStdErr, false, stdOutDescriptor, timeoutMs, timedOut);
+	}
+
+#endif
+
+int executeProcessWithPipes(const std::string& command, const string& writeThisToStdIn, string& thisReceivesStdOut, string& thisReceivesStdErr, bool combineStdErrWithStdOut, int timeoutMs, bool* timedOut) {
+	return executeProcessWithCallbacks(command, writeThisToStdIn, append_to(thisReceivesStdOut), append_to(thisReceivesStdErr), combineStdErrWithStdOut, timeoutMs, timedOut);
+}
+
+//A job submitted to a ProcessPool
+#ifdef _WIN32
+
+	struct PoolJob
+	{
+		int id;
+		string command;
+		string input;
+		bool combineStdErrWithStdOut;
+		std::thread worker;
+	};
+
+#else
+
+	struct PoolJob
+	{
+		int id;
+		string command;
+		string input;
+		bool combineStdErrWithStdOut;
+		pid_t pid;
+		int pidfd;                  //-1 if pidfd_open() is not supported, in which case we poll for the child's exit
+		struct pollfd pipes[3];
+		size_t bytesWritten;
+		bool exited;
+		std::chrono::steady_clock::time_point startTime;
+	};
+
+#endif
+
+struct ProcessPoolState
+{
+	unsigned int maxConcurrent;
+	std::deque<ProcessResult> results;    //A deque, so that references to existing results remain valid as jobs are submitted
+	vector<bool> completed;
+	std::deque<int> unreported;           //Completed jobs that have not yet been returned by waitAny()
+	std::deque<PoolJob*> queued;
+	vector<PoolJob*> running;
+	
+	#ifdef _WIN32
+		std::mutex finishedLock;
+		std::condition_variable finishedCondition;
+		vector<PoolJob*> finished;        //Jobs whose worker threads have completed but have not yet been joined
+	#endif
+};
+
+//Marks a job as completed and frees it (the job must no longer be in the running list)
+static void complete_job(ProcessPoolState* state, PoolJob* job)
+{
+	state->completed[job->id] = true;
+	state->unreported.push_back(job->id);
+	delete job;
+}
+
+//Removes the completed jobs from the running list and marks them as completed
+static void complete_jobs(ProcessPoolState* state, const vector<PoolJob*>& jobs)
+{
+	for (vector<PoolJob*>::const_iterator job = jobs.begin(); job != jobs.end(); ++job)
+	{
+		state->running.erase(std::find(state->running.begin(), state->running.end(), *job));
+		complete_job(state, *job);
+	}
+}
+
+#ifdef _WIN32
+
+	//Starts a job on its own worker thread, which services the pipes using executeProcessWithPipes()
+	static bool start_job(ProcessPoolState* state, PoolJob* job)
+	{
+		//The result is retrieved here, since the deque may be modified by submit() while the worker is running
+		ProcessResult* result = &state->results[job->id];
+		job->worker = std::thread([state, job, result]()
 		{
-			//Parent process
+			std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+			result->exitCode = executeProcessWithPipes(job->command, job->input, result->stdOut, result->stdErr, job->combineStdErrWithStdOut);
+			result->wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
 			
-			//Close the ends of the pipes that we won't be using
-			close(pStdIn[0]);
-			close(pStdOut[1]);
-			close(pStdErr[1]);
+			std::lock_guard<std::mutex> lock(state->finishedLock);
+			state->finished.push_back(job);
+			state->finishedCondition.notify_one();
+		});
+		
+		return true;
+	}
+	
+	//Waits until at least one running job has completed, or the timeout expires
+	static void service_jobs(ProcessPoolState* state, int timeoutMs)
+	{
+		vector<PoolJob*> finished;
+		{
+			std::unique_lock<std::mutex> lock(state->finishedLock);
+			if (timeoutMs >= 0) {
+				state->finishedCondition.wait_for(lock, std::chrono::milliseconds(timeoutMs), [state]() { return !state->finished.empty(); });
+			}
+			else {
+				state->finishedCondition.wait(lock, [state]() { return !state->finished.empty(); });
+			}
 			
-			//Write any data to the child's stdin
-			if (writeThisToStdIn.length() > 0) {
-				write(pStdIn[1], writeThisToStdIn.data(), writeThisToStdIn.length());
+			finished.swap(state->finished);
+		}
+		
+		for (vector<PoolJob*>::iterator job = finished.begin(); job != finished.end(); ++job) {
+			(*job)->worker.join();
+		}
+		
+		complete_jobs(state, finished);
+	}
+
+#else
+
+	static double seconds_from_timeval(const struct timeval& time) {
+		return (double)time.tv_sec + ((double)time.tv_usec / 1000000.0);
+	}
+	
+	//Starts a job's child process
+	static bool start_job(ProcessPoolState* state, PoolJob* job)
+	{
+		job->bytesWritten = 0;
+		job->exited       = false;
+		job->startTime    = std::chrono::steady_clock::now();
+		job->pid          = spawn_with_pipes(job->command, job->combineStdErrWithStdOut, -1, job->pipes);
+		if (job->pid == -1) {
+			return false;
+		}
+		
+		//A pidfd becomes readable when the child exits, so that we can wait for output and exits in a single poll() call
+		job->pidfd = -1;
+		#ifdef SYS_pidfd_open
+		job->pidfd = (int)syscall(SYS_pidfd_open, job->pid, 0);
+		#endif
+		
+		return true;
+	}
+	
+	//Services the pipes of all running jobs and reaps any children that have exited, waiting until at least one
+	//pipe or child is ready (or the timeout expires)
+	static void service_jobs(ProcessPoolState* state, int timeoutMs)
+	{
+		//Gather the descriptors for all of the running jobs, noting whether any children need to be polled for their exit
+		vector<struct pollfd> descriptors;
+		bool pollForExit = false;
+		for (vector<PoolJob*>::iterator job = state->running.begin(); job != state->running.end(); ++job)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				if ((*job)->pipes[i].fd != -1) {
+					descriptors.push_back((*job)->pipes[i]);
+				}
 			}
-			close(pStdIn[1]);
 			
-			//Read data from the child's stdout
-			char buffStdOut[100];
-			size_t bytesReadStdOut = 0;
-			while ((bytesReadStdOut = read(pStdOut[0], buffStdOut, sizeof(buffStdOut))) > 0) {
-				thisReceivesStdOut.append(buffStdOut, bytesReadStdOut);
+			if (!(*job)->exited && (*job)->pidfd != -1)
+			{
+				struct pollfd pidfd = {(*job)->pidfd, POLLIN, 0};
+				descriptors.push_back(pidfd);
+			}
+			else if (!(*job)->exited) {
+				pollForExit = true;
+			}
+		}
+		
+		if (pollForExit && (timeoutMs < 0 || timeoutMs > 10)) {
+			timeoutMs = 10;
+		}
+		
+		sigset_t previousMask;
+		bool sigpipeAlreadyPending = block_sigpipe(&previousMask);
+		if (poll(descriptors.data(), descriptors.size(), timeoutMs) == -1)
+		{
+			for (vector<struct pollfd>::iterator descriptor = descriptors.begin(); descriptor != descriptors.end(); ++descriptor) {
+				descriptor->revents = 0;
+			}
+		}
+		
+		//Service the pipes of each job and reap its child if it has exited
+		vector<char> buffer(PIPE_BUFFER_SIZE);
+		vector<PoolJob*> finished;
+		size_t index = 0;
+		for (vector<PoolJob*>::iterator job = state->running.begin(); job != state->running.end(); ++job)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				if ((*job)->pipes[i].fd != -1) {
+					(*job)->pipes[i].revents = descriptors[index++].revents;
+				}
 			}
 			
-			//Read data from the child's stderr
-			char buffStdErr[100];
-			size_t bytesReadStdErr = 0;
-			while ((bytesReadStdErr = read(pStdErr[0], buffStdErr, sizeof(buffStdErr))) > 0) {
-				thisReceivesStdErr.append(buffStdErr, bytesReadStdErr);
+			bool exitReady = pollForExit;
+			if (!(*job)->exited && (*job)->pidfd != -1) {
+				exitReady = (descriptors[index++].revents != 0);
 			}
 			
-			//Wait for the child process to complete and retrieve the return code
-			int returnCode = -1;
+			ProcessResult& result = state->results[(*job)->id];
+			OutputCallback onStdOut = append_to(result.stdOut);
+			OutputCallback onStdErr = append_to(result.stdErr);
+			const OutputCallback* callbacks[3] = {NULL, &onStdOut, &onStdErr};
+			service_pipes((*job)->pipes, (*job)->input, (*job)->bytesWritten, callbacks, buffer);
+			
+			//wait4() provides the CPU time used by the child along with its exit status
 			int status = 0;
-			waitpid(childPid, &status, 0);
-			if (WIFEXITED(status)) {
-				returnCode = WEXITSTATUS(status);
+			struct rusage usage;
+			if (!(*job)->exited && exitReady && wait4((*job)->pid, &status, WNOHANG, &usage) == (*job)->pid)
+			{
+				(*job)->exited    = true;
+				result.exitCode   = (WIFEXITED(status)) ? WEXITSTATUS(status) : -1;
+				result.wallTime   = std::chrono::duration<double>(std::chrono::steady_clock::now() - (*job)->startTime).count();
+				result.userTime   = seconds_from_timeval(usage.ru_utime);
+				result.systemTime = seconds_from_timeval(usage.ru_stime);
+				if ((*job)->pidfd != -1) {
+					close((*job)->pidfd);
+				}
 			}
 			
-			//Close the remaining ends of the pipes
-			close(pStdOut[0]);
-			close(pStdErr[0]);
+			//A job is complete once its child has exited and all of its output has been read
+			if ((*job)->exited && (*job)->pipes[0].fd == -1 && (*job)->pipes[1].fd == -1 && (*job)->pipes[2].fd == -1) {
+				finished.push_back(*job);
+			}
+		}
+		
+		restore_sigpipe(previousMask, sigpipeAlreadyPending);
+		complete_jobs(state, finished);
+	}
+
+#endif
+
+//Starts queued jobs until the concurrency limit is reached (jobs that cannot be started are completed immediately)
+static void start_queued_jobs(ProcessPoolState* state)
+{
+	while (state->running.size() < state->maxConcurrent && !state->queued.empty())
+	{
+		PoolJob* job = state->queued.front();
+		state->queued.pop_front();
+		if (start_job(state, job)) {
+			state->running.push_back(job);
+		}
+		else {
+			complete_job(state, job);
+		}
+	}
+}
+
+ProcessPool::ProcessPool(unsigned int maxConcurrent)
+{
+	this->state = new ProcessPoolState();
+	this->state->maxConcurrent = (maxConcurrent > 0) ? maxConcurrent : std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+ProcessPool::~ProcessPool()
+{
+	this->waitAll();
+	delete this->state;
+}
+
+int ProcessPool::submit(const string& command, const string& writeThisToStdIn, bool combineStdErrWithStdOut)
+{
+	int id = (int)this->state->results.size();
+	PoolJob* job = new PoolJob();
+	job->id                      = id;
+	job->command                 = command;
+	job->input                   = writeThisToStdIn;
+	job->combineStdErrWithStdOut = combineStdErrWithStdOut;
+	
+	ProcessResult result = {-1, "", "", 0.0, 0.0, 0.0};
+	this->state->results.push_back(result);
+	this->state->completed.push_back(false);
+	this->state->queued.push_back(job);
+	
+	//If the job cannot be started, it is completed (and freed) straight away
+	start_queued_jobs(this->state);
+	return id;
+}
+
+bool ProcessPool::finished(int job) const {
+	return this->state->completed[job];
+}
+
+const ProcessResult& ProcessPool::result(int job) const {
+	return this->state->results[job];
+}
+
+int ProcessPool::wait(int job)
+{
+	while (!this->state->completed[job])
+	{
+		service_jobs(this->state, -1);
+		start_queued_jobs(this->state);
+	}
+	
+	return this->state->results[job].exitCode;
+}
+
+int ProcessPool::waitAny(int timeoutMs)
+{
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+	while (this->state->unreported.empty() && !this->state->running.empty())
+	{
+		//If a timeout was specified, determine how much longer we can wait
+		int waitMs = -1;
+		if (timeoutMs >= 0)
+		{
+			int64_t remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+			if (remaining < 0) {
+				return -1;
+			}
 			
-			//Return the return code
-			return returnCode;
+			waitMs = (int)remaining;
 		}
 		
-		return -1;
+		service_jobs(this->state, waitMs);
+		start_queued_jobs(this->state);
 	}
 	
-	#undef __MAX_ARGV_ARGS
+	if (this->state->unreported.empty()) {
+		return -1;
+	}
 	
-#endif
+	int job = this->state->unreported.front();
+	this->state->unreported.pop_front();
+	return job;
+}
+
+void ProcessPool::waitAll()
+{
+	while (!this->state->running.empty())
+	{
+		service_jobs(this->state, -1);
+		start_queued_jobs(this->state);
+	}
+}
+
+unsigned int ProcessPool::running() const {
+	return (unsigned int)this->state->running.size();
+}
+
+unsigned int ProcessPool::queued() const {
+	return (unsigned int)this->state->queued.size();
+}
 
 //Uses platform-specific CLI functionality to get a password without displaying the characters
 string get_cli_password_hidden(string prompt)
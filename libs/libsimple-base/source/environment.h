@@ -30,10 +30,13 @@
 
 #include <cstdlib>
 #include <cstdio>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <vector>
 using std::string;
+using std::string_view;
 using std::stringstream;
 using std::vector;
 
@@ -41,13 +44,161 @@ string temp_dir(bool trailing_slash = false); //Retrieves the temporary director
 string capture_output(string command);        //Wrapper for the C-String version of this function
 string capture_output(const char* command);   //Executes the specified command and retrieves the command-line output
 string read_entire_stdin();                   //Reads all input from standard input and returns it as a string
-string generate_unique_filename();            //Generates a unique file name in the temporary files directory
+string generate_unique_filename();            //Generates a random file name in the temporary files directory (use TempFile or TempDirectory to create one safely)
+
+//Binary-safe versions of capture_output() and read_entire_stdin(), which append the data to the output string (using large reads
+//directly into the string) and return false if the command could not be executed or a read failed. If exitCode is not NULL, it
+//receives the exit code of the command. Standard input is read directly from its descriptor, bypassing any stdio buffering.
+bool capture_output(const string& command, string& output, int* exitCode = NULL);
+bool read_entire_stdin(string& output);
+
+//Reads the next chunk of standard input (of at most the size of the buffer), for processing input too large to hold in memory.
+//Returns a view of the data in the buffer, which is empty once the end of the input is reached (or if a read fails).
+string_view read_stdin_chunk(vector<char>& buffer);
 
 //Wraps around getenv to support std::strings
 string get_env(const string& var);
 
-//Executes a command, writing to its stdin, retrieving the stdout and stderr, and returns the return code
-int executeProcessWithPipes(const std::string& command, const string& writeThisToStdIn, string& thisReceivesStdOut, string& thisReceivesStdErr, bool combineStdErrWithStdOut = false);
+//RAII handle for a temporary file, which is opened for reading and writing and is deleted when the handle is destroyed.
+//Names are generated using a random suffix from a per-thread generator, and the file is created exclusively (retrying with
+//a new name if necessary), so concurrent threads and processes can never receive the same file.
+class TempFile
+{
+	public:
+		//Creates a file in the specified directory (or the temporary files directory, if empty). If anonymous is true, the file is
+		//created using O_TMPFILE where supported (Linux), so that it has no name (and nothing is left behind if the process is killed).
+		explicit TempFile(const string& directory = "", const string& prefix = "tmp", bool anonymous = false);
+		~TempFile();
+		
+		//Determines if the file was created successfully
+		bool isOpen() const { return this->fd != -1; }
+		
+		//The descriptor for the file, and its path (which is empty for anonymous files)
+		int descriptor() const { return this->fd; }
+		const string& path() const { return this->filePath; }
+		
+		//Closes the file and moves it to the specified path, so that it is no longer deleted.
+		//Anonymous files are given a name using linkat(), which fails if the destination already exists.
+		bool keep(const string& destination);
+		
+		//Closes and deletes the file straight away
+		void remove();
+	
+	private:
+		TempFile(const TempFile& other);
+		TempFile& operator=(const TempFile& other);
+		
+		int fd;
+		string filePath;
+};
+
+//RAII handle for a temporary directory, which is deleted along with all of its contents when the handle is destroyed.
+//Names are generated in the same manner as TempFile, and the directory is only accessible by the current user.
+class TempDirectory
+{
+	public:
+		//Creates a directory inside the specified parent directory (or the temporary files directory, if empty)
+		explicit TempDirectory(const string& parent = "", const string& prefix = "tmp");
+		~TempDirectory();
+		
+		//Determines if the directory was created successfully
+		bool isOpen() const { return !this->dirPath.empty(); }
+		
+		//The path of the directory
+		const string& path() const { return this->dirPath; }
+		
+		//Leaves the directory in place when the handle is destroyed
+		void keep();
+		
+		//Deletes the directory and its contents straight away, returning false if anything could not be deleted
+		bool remove();
+	
+	private:
+		TempDirectory(const TempDirectory& other);
+		TempDirectory& operator=(const TempDirectory& other);
+		
+		string dirPath;
+};
+
+//Executes a command, writing to its stdin, retrieving the stdout and stderr, and returns the return code.
+//All three streams are serviced concurrently, so a child that fills one pipe while we are busy with another cannot deadlock.
+//If timeoutMs is not negative and the child runs for longer than this, it is killed, timedOut is set to true and -1 is returned.
+//Returns -1 if the command could not be started. Under POSIX systems, the child is started using posix_spawn() rather than fork().
+int executeProcessWithPipes(const std::string& command, const string& writeThisToStdIn, string& thisReceivesStdOut, string& thisReceivesStdErr, bool combineStdErrWithStdOut = false, int timeoutMs = -1, bool* timedOut = NULL);
+
+//Receives a chunk of a child process's output, returning false to stop the child
+typedef std::function<bool(const char* data, size_t length)> OutputCallback;
+
+//Executes a command in the same manner as executeProcessWithPipes(), but passes the stdout and stderr to the callbacks in chunks as
+//they arrive, rather than accumulating them, so that memory usage does not grow with the size of the output. Either callback may be
+//empty to discard that stream. The callbacks are never invoked concurrently. If a callback returns false, the child is killed and -1
+//is returned.
+int executeProcessWithCallbacks(const std::string& command, const string& writeThisToStdIn, const OutputCallback& onStdOut, const OutputCallback& onStdErr, bool combineStdErrWithStdOut = false, int timeoutMs = -1, bool* timedOut = NULL);
+
+#ifndef _WIN32
+
+//Executes a command in the same manner as executeProcessWithCallbacks(), but the child writes its stdout directly to the specified
+//descriptor (such as an open file, pipe or socket), so that the data never passes through this process at all
+int executeProcessToDescriptor(const std::string& command, const string& writeThisToStdIn, int stdOutDescriptor, const OutputCallback& onStdErr, int timeoutMs = -1, bool* timedOut = NULL);
+
+#endif
+
+//The result of a command run by a ProcessPool
+struct ProcessResult
+{
+	int    exitCode;      //The exit code of the command, or -1 if it could not be started or was killed by a signal
+	string stdOut;
+	string stdErr;
+	double wallTime;      //The time in seconds from starting the command to its exit
+	double userTime;      //The CPU time in seconds used by the command in user mode and in the kernel (zero under Windows)
+	double systemTime;
+};
+
+struct ProcessPoolState;
+
+//Runs commands with at most a fixed number of them running at once, capturing the output of each one separately.
+//Commands are started in the order they are submitted, and are only started or serviced during calls to submit() and the
+//wait functions. Under POSIX systems, a single thread supervises all of the running children using non-blocking pipes
+//(and pidfds under Linux). Under Windows, each running command is serviced by its own thread.
+//A ProcessPool object must only be used by one thread at a time.
+class ProcessPool
+{
+	public:
+		//Creates a pool that runs at most maxConcurrent commands at once (zero means one per core)
+		ProcessPool(unsigned int maxConcurrent = 0);
+		
+		//Waits for all submitted commands to complete
+		~ProcessPool();
+		
+		//Submits a command, starting it straight away if the pool is not full, and returns its job ID (IDs count up from zero)
+		int submit(const string& command, const string& writeThisToStdIn = "", bool combineStdErrWithStdOut = false);
+		
+		//Determines if a job has completed
+		bool finished(int job) const;
+		
+		//Retrieves the result of a job, which is only complete once the job has finished
+		const ProcessResult& result(int job) const;
+		
+		//Waits for a job to complete, returning its exit code
+		int wait(int job);
+		
+		//Waits for any job to complete, returning its ID. Each job is only returned once. Returns -1 if all submitted
+		//jobs have already been returned, or if timeoutMs is not negative and expires before a job completes.
+		int waitAny(int timeoutMs = -1);
+		
+		//Waits for all submitted jobs to complete
+		void waitAll();
+		
+		//The number of jobs that are running, and the number waiting to be started
+		unsigned int running() const;
+		unsigned int queued() const;
+	
+	private:
+		ProcessPool(const ProcessPool& other);
+		ProcessPool& operator=(const ProcessPool& other);
+		
+		ProcessPoolState* state;
+};
 
 //Uses platform-specific CLI functionality to get a password without displaying the characters
 string get_cli_password_hidden(string prompt);
@@ -134,47 +285,31 @@ vector<string> glob(const string& pattern);
 	}
 #endif
 
-//Linux version of MonitorDirectoryForFileWrites, using inotify
+//Linux version of MonitorDirectoryForFileWrites, using inotify (see DirectoryWatcher for a more flexible interface)
 #ifdef __linux__
 #include <unistd.h>
-#include <sys/inotify.h>
+#include "DirectoryWatcher.h"
 
 template <typename CallbackTy>
 void MonitorDirectoryForFileWrites(const string& dir, CallbackTy callback)
 {
 	//Setup the watch
-	int inotifyDescriptor = inotify_init();
-	int watchDescriptor = inotify_add_watch(inotifyDescriptor, dir.c_str(), IN_ALL_EVENTS);
-	
-	//Prepare the buffer
-	int bufSize = (sizeof(inotify_event) + 16) * 1024;
-	char buffer[bufSize];
-	
-	//This will hold the return value of the callback
-	//We exit when the callback returns false
-	bool callbackReturn = true;
+	DirectoryWatcher watcher(IN_ALL_EVENTS);
+	if (!watcher.addDirectory(dir)) {
+		return;
+	}
 	
-	//This should be equivalent to a while(1) so long as the watch is not deleted
-	int len = 0;
-	do
+	//Execute the callback once for each event, until the callback returns false or the watch is deleted
+	vector<WatchEvent> events;
+	while (watcher.readEvents(events))
 	{
-		len = read(inotifyDescriptor, buffer, bufSize);
-		int i = 0;
-		while (i < len && callbackReturn == true)
+		for (size_t i = 0; i < events.size(); ++i)
 		{
-			inotify_event* event = (inotify_event*)buffer + i;
-			
-			//Execute the callback
-			callbackReturn = callback();
-			
-			i += sizeof(inotify_event) + event->len;
+			if (callback() == false) {
+				return;
+			}
 		}
 	}
-	while (len > 0 && callbackReturn == true);
-	
-	//Cleanup
-	inotify_rm_watch(inotifyDescriptor, watchDescriptor);
-	close(inotifyDescriptor);
 }
 
 #endif
@@ -28,26 +28,58 @@
 */
 #include "file_manipulation.h"
 #include "string_manipulation.h"
+#include "StringBuilder.h"
+#include "FilePath.h"
+#include "profiling.h"
+
+#include <algorithm>
+#include <atomic>
+#include <errno.h>
+#include <thread>
+#include <fcntl.h>
 
 #ifdef _WIN32
 	#include <direct.h>
+	#include <io.h>
+	#include <process.h>
+	#include <windows.h>
+#else
+	#include <limits.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/uio.h>
+	
+	#ifdef __linux__
+	#include <linux/fs.h>
+	#include <sys/ioctl.h>
+	#include <sys/sendfile.h>
+	#endif
+	
+	//Not all platforms define IOV_MAX
+	#ifndef IOV_MAX
+	#define IOV_MAX 1024
+	#endif
 #endif
 
 //Implementations of PHP Functions (std::string is utilised in a binary-safe manner when dealing with data)
 
 string file_get_contents(const string& path)
 {
-	//Open the specified input file in binary mode
-	ifstream infile(path.c_str(), ios::binary);
+	PROFILE_ZONE_DETAIL("file_get_contents", path.c_str());
 	
 	//Create a string to hold the file contents
 	string contents;
 	
+	#ifdef _WIN32
+	
+	//Open the specified input file in binary mode
+	ifstream infile(path.c_str(), ios::binary);
+	
 	//Check to ensure that the file opened correctly
 	if (infile.is_open())
 	{
 		//Read the contents one chunk at a time
-		char buffer[1024*1024];
+		char buffer[64*1024];
 		size_t bytesRead = 0;
 		while ( (bytesRead = infile.read(buffer, sizeof(buffer)).gcount()) != 0 )
 		{
@@ -59,6 +91,56 @@ string file_get_contents(const string& path)
 		infile.close();
 	}
 	
+	#else
+	
+	//Open the specified input file
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return contents;
+	}
+	
+	//For regular files, size the string up front and read directly into it
+	size_t filled = 0;
+	struct stat fileInfo;
+	if (fstat(fd, &fileInfo) == 0 && S_ISREG(fileInfo.st_mode) && fileInfo.st_size > 0)
+	{
+		contents.resize(fileInfo.st_size);
+		while (filled < contents.length())
+		{
+			ssize_t bytesRead = read(fd, &contents[filled], contents.length() - filled);
+			if (bytesRead == -1 && errno == EINTR) {
+				continue;
+			}
+			else if (bytesRead <= 0) {
+				break;
+			}
+			
+			filled += bytesRead;
+		}
+		
+		//The file may have shrunk since we called fstat()
+		contents.resize(filled);
+	}
+	
+	//Read anything that remains (this covers pipes, procfs files, and files that have grown since we called fstat())
+	char buffer[64*1024];
+	ssize_t bytesRead = 0;
+	while ( (bytesRead = read(fd, buffer, sizeof(buffer))) != 0 )
+	{
+		if (bytesRead == -1 && errno == EINTR) {
+			continue;
+		}
+		else if (bytesRead == -1) {
+			break;
+		}
+		
+		contents.append(buffer, bytesRead);
+	}
+	
+	close(fd);
+	
+	#endif
+	
 	//Return the data
 	return contents;
 }
@@ -120,28 +202,399 @@ off_t filesize (const string& path)
 	return -1;
 }
 
-bool file_put_contents(const string& path, const string& data)
+bool file_put_contents(const string& path, const string& data) {
+	return file_put_contents(path, vector<string_view>(1, data), FileWriteOptions());
+}
+
+bool file_put_contents(const string& path, const string& data, const FileWriteOptions& options) {
+	return file_put_contents(path, vector<string_view>(1, data), options);
+}
+
+bool write_all(int fd, const char* data, size_t length)
+{
+	while (length > 0)
+	{
+		#ifdef _WIN32
+		//_write() takes an unsigned int count, so write very large buffers in pieces
+		unsigned int count = (length > 0x40000000) ? 0x40000000 : (unsigned int)length;
+		int written = _write(fd, data, count);
+		#else
+		ssize_t written = write(fd, data, length);
+		#endif
+		
+		if (written == -1 && errno == EINTR) {
+			continue;
+		}
+		else if (written <= 0) {
+			return false;
+		}
+		
+		data   += written;
+		length -= written;
+	}
+	
+	return true;
+}
+
+//Writes the supplied buffers to a file descriptor in order, retrying for partial writes and interrupts
+static bool write_buffers(int fd, const vector<string_view>& buffers)
 {
-	//Opens the specified output file in binary mode, overwriting the file if it already exists
-	ofstream outfile(path.c_str(), ios::binary);
+	#ifdef _WIN32
 	
-	//Check to ensure that the file opened correctly
-	if (outfile.is_open())
+	for (vector<string_view>::const_iterator currBuffer = buffers.begin(); currBuffer != buffers.end(); ++currBuffer)
+	{
+		if (!write_all(fd, currBuffer->data(), currBuffer->length())) {
+			return false;
+		}
+	}
+	
+	#else
+	
+	//Build the list of iovecs, skipping any empty buffers
+	vector<struct iovec> iov;
+	iov.reserve(buffers.size());
+	for (vector<string_view>::const_iterator currBuffer = buffers.begin(); currBuffer != buffers.end(); ++currBuffer)
 	{
-		//Write the data to the file
-		outfile.write(data.data(), data.length());
+		if (!currBuffer->empty())
+		{
+			struct iovec entry;
+			entry.iov_base = (void*)currBuffer->data();
+			entry.iov_len  = currBuffer->length();
+			iov.push_back(entry);
+		}
+	}
+	
+	size_t index = 0;
+	while (index < iov.size())
+	{
+		//writev() accepts at most IOV_MAX buffers per call
+		size_t count = iov.size() - index;
+		if (count > IOV_MAX) {
+			count = IOV_MAX;
+		}
 		
-		//Close the file
-		outfile.close();
-		return true;
+		ssize_t written = writev(fd, &iov[index], (int)count);
+		if (written == -1 && errno == EINTR) {
+			continue;
+		}
+		else if (written <= 0) {
+			return false;
+		}
+		
+		//Skip past the buffers that were written completely, and advance into any that was written partially
+		size_t consumed = written;
+		while (index < iov.size() && consumed >= iov[index].iov_len)
+		{
+			consumed -= iov[index].iov_len;
+			++index;
+		}
+		
+		if (consumed > 0)
+		{
+			iov[index].iov_base  = (char*)iov[index].iov_base + consumed;
+			iov[index].iov_len  -= consumed;
+		}
+	}
+	
+	#endif
+	
+	return true;
+}
+
+//Creates a uniquely-named temporary file in the same directory as the specified target, so that it can be renamed over the target
+static int create_sibling_temp_file(const string& path, string& tempPath)
+{
+	static std::atomic<unsigned int> counter(0);
+	
+	#ifdef _WIN32
+	unsigned int pid = (unsigned int)_getpid();
+	#else
+	unsigned int pid = (unsigned int)getpid();
+	#endif
+	
+	for (int attempt = 0; attempt < 100; ++attempt)
+	{
+		//Combine the process ID, a per-process counter and the current time, to avoid collisions with other writers
+		StringBuilder name(path.length() + 32);
+		name.append(path).append(".tmp.");
+		name.appendUInt(pid).append('.');
+		name.appendUInt(counter++).append('.');
+		name.appendUInt((uint64_t)time(NULL));
+		tempPath = name.release();
+		
+		#ifdef _WIN32
+		int fd = _open(tempPath.c_str(), _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE);
+		#else
+		int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+		#endif
+		
+		if (fd != -1 || errno != EEXIST) {
+			return fd;
+		}
+	}
+	
+	return -1;
+}
+
+bool file_put_contents(const string& path, const vector<string_view>& buffers, const FileWriteOptions& options)
+{
+	PROFILE_ZONE("file_put_contents");
+	
+	//Open either the target itself (truncating it) or a temporary file to rename over it
+	string outputPath = path;
+	int fd = -1;
+	if (options.atomic) {
+		fd = create_sibling_temp_file(path, outputPath);
 	}
 	else
 	{
-		//The file couldn't be opened
+		#ifdef _WIN32
+		fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+		#else
+		fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+		#endif
+	}
+	
+	if (fd == -1) {
 		return false;
 	}
+	
+	#ifndef _WIN32
+	
+	//When replacing an existing file, give the replacement the same permissions
+	struct stat existing;
+	if (options.atomic && stat(path.c_str(), &existing) == 0) {
+		fchmod(fd, existing.st_mode & 07777);
+	}
+	
+	#endif
+	
+	#ifdef __linux__
+	
+	//Reserve space for the entire file up front, so that it is allocated contiguously where possible
+	//(failure is not an error, since not all filesystems support fallocate())
+	if (options.preallocate)
+	{
+		size_t total = 0;
+		for (vector<string_view>::const_iterator currBuffer = buffers.begin(); currBuffer != buffers.end(); ++currBuffer) {
+			total += currBuffer->length();
+		}
+		
+		if (total > 0) {
+			fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, total);
+		}
+	}
+	
+	#endif
+	
+	//Write the data and flush it to disk if requested
+	bool success = write_buffers(fd, buffers);
+	if (success && options.sync != FileWriteOptions::NoSync)
+	{
+		#if defined(_WIN32)
+		success = (_commit(fd) == 0);
+		#elif defined(__linux__)
+		success = (((options.sync == FileWriteOptions::SyncData) ? fdatasync(fd) : fsync(fd)) == 0);
+		#else
+		success = (fsync(fd) == 0);
+		#endif
+	}
+	
+	#ifdef _WIN32
+	success = (_close(fd) == 0) && success;
+	#else
+	success = (close(fd) == 0) && success;
+	#endif
+	
+	if (options.atomic)
+	{
+		//Move the temporary file into place, or remove it if anything failed
+		#ifdef _WIN32
+		if (!success || MoveFileExA(outputPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) == 0)
+		{
+			_unlink(outputPath.c_str());
+			return false;
+		}
+		#else
+		if (!success || rename(outputPath.c_str(), path.c_str()) != 0)
+		{
+			unlink(outputPath.c_str());
+			return false;
+		}
+		
+		//Sync the parent directory so that the rename itself survives a crash
+		if (options.sync != FileWriteOptions::NoSync)
+		{
+			int dirFd = open(string(FilePath(path).dirname()).c_str(), O_RDONLY);
+			if (dirFd != -1)
+			{
+				fsync(dirFd);
+				close(dirFd);
+			}
+		}
+		#endif
+	}
+	
+	return success;
 }
 
+int64_t copy_range(int srcFd, int64_t srcOffset, int dstFd, int64_t dstOffset, int64_t length, CopyRangeMethod* method)
+{
+	PROFILE_ZONE("copy_range");
+	
+	if (method != NULL) {
+		*method = COPY_RANGE_NONE;
+	}
+	
+	if (srcFd == -1 || dstFd == -1 || srcOffset < 0 || dstOffset < -1 || length < 0) {
+		return -1;
+	}
+	
+	//Resolve the destination offset, since the kernel mechanisms take explicit offsets (this will be -1 for pipes and sockets)
+	bool useCurrentOffset = (dstOffset == -1);
+	#ifdef _WIN32
+	int64_t dstStart = (useCurrentOffset) ? _lseeki64(dstFd, 0, SEEK_CUR) : dstOffset;
+	#else
+	int64_t dstStart = (useCurrentOffset) ? (int64_t)lseek(dstFd, 0, SEEK_CUR) : dstOffset;
+	#endif
+	
+	int64_t copied = 0;
+	bool reachedEnd = (length == 0);
+	
+	#ifdef __linux__
+	
+	if (dstStart != -1)
+	{
+		//The kernel silently shortens a clone that extends past the end of the source without reporting how much was cloned,
+		//so clamp the length to the end of the source ourselves in order to report the correct count
+		int64_t cloneLength = 0;
+		struct stat srcDetails;
+		if (fstat(srcFd, &srcDetails) == 0 && S_ISREG(srcDetails.st_mode) && srcDetails.st_size > srcOffset) {
+			cloneLength = std::min(length, (int64_t)srcDetails.st_size - srcOffset);
+		}
+		
+		//Attempt to share the source extents with the destination, which only succeeds on copy-on-write filesystems for block-aligned ranges
+		struct file_clone_range clone;
+		clone.src_fd      = srcFd;
+		clone.src_offset  = srcOffset;
+		clone.src_length  = cloneLength;
+		clone.dest_offset = dstStart;
+		if (!reachedEnd && cloneLength > 0 && ioctl(dstFd, FICLONERANGE, &clone) == 0)
+		{
+			copied = cloneLength;
+			reachedEnd = true;
+			if (method != NULL) {
+				*method = COPY_RANGE_REFLINK;
+			}
+		}
+		
+		//Otherwise, have the kernel copy the data directly between the files (this fails across filesystems prior to Linux 5.3)
+		while (!reachedEnd && copied < length)
+		{
+			loff_t in  = srcOffset + copied;
+			loff_t out = dstStart + copied;
+			ssize_t result = copy_file_range(srcFd, &in, dstFd, &out, length - copied, 0);
+			if (result == -1 && errno == EINTR) {
+				continue;
+			}
+			else if (result == -1) {
+				break;
+			}
+			
+			reachedEnd = (result == 0);
+			copied += result;
+			if (method != NULL && result > 0) {
+				*method = COPY_RANGE_COPY_FILE_RANGE;
+			}
+		}
+	}
+	
+	#endif
+	
+	//The remaining mechanisms write at the current offset, so position the destination after whatever has been copied so far
+	if (!reachedEnd && copied < length && dstStart != -1)
+	{
+		#ifdef _WIN32
+		_lseeki64(dstFd, dstStart + copied, SEEK_SET);
+		#else
+		lseek(dstFd, dstStart + copied, SEEK_SET);
+		#endif
+	}
+	
+	#ifdef __linux__
+	
+	//Have the kernel copy the data using sendfile(), which also supports pipes and sockets as the destination
+	while (!reachedEnd && copied < length)
+	{
+		off_t in = srcOffset + copied;
+		size_t count = (length - copied > 0x40000000) ? 0x40000000 : (size_t)(length - copied);
+		ssize_t result = sendfile(dstFd, srcFd, &in, count);
+		if (result == -1 && errno == EINTR) {
+			continue;
+		}
+		else if (result == -1) {
+			break;
+		}
+		
+		reachedEnd = (result == 0);
+		copied += result;
+		if (method != NULL && result > 0) {
+			*method = COPY_RANGE_SENDFILE;
+		}
+	}
+	
+	#endif
+	
+	//Copy anything that remains through a large userspace buffer
+	if (!reachedEnd && copied < length)
+	{
+		vector<char> buffer(1024 * 1024);
+		
+		#ifdef _WIN32
+		_lseeki64(srcFd, srcOffset + copied, SEEK_SET);
+		#endif
+		
+		while (!reachedEnd && copied < length)
+		{
+			size_t count = (length - copied > (int64_t)buffer.size()) ? buffer.size() : (size_t)(length - copied);
+			
+			#ifdef _WIN32
+			int bytesRead = _read(srcFd, &buffer[0], (unsigned int)count);
+			#else
+			ssize_t bytesRead = pread(srcFd, &buffer[0], count, srcOffset + copied);
+			#endif
+			
+			if (bytesRead == -1 && errno == EINTR) {
+				continue;
+			}
+			else if (bytesRead == -1) {
+				return -1;
+			}
+			
+			reachedEnd = (bytesRead == 0);
+			if (!write_buffers(dstFd, vector<string_view>(1, string_view(&buffer[0], bytesRead)))) {
+				return -1;
+			}
+			
+			copied += bytesRead;
+			if (method != NULL && bytesRead > 0) {
+				*method = COPY_RANGE_BUFFERED;
+			}
+		}
+	}
+	
+	//When writing at the current offset, leave it positioned after the copied data
+	if (useCurrentOffset && dstStart != -1)
+	{
+		#ifdef _WIN32
+		_lseeki64(dstFd, dstStart + copied, SEEK_SET);
+		#else
+		lseek(dstFd, dstStart + copied, SEEK_SET);
+		#endif
+	}
+	
+	return copied;
+}
 
 //My Functions
 
@@ -163,15 +616,153 @@ void write_random_bytes(ofstream& outfile, int number)
 {
 	if (outfile.is_open())
 	{
-		//Seed the random number generator
-		srand(time(NULL));
-		for (int i = 0; i < number; ++i)
+		//Generate and write the data in chunks, seeding from the system's entropy source so that successive calls produce different data
+		RandomDataGenerator generator;
+		char buffer[64*1024];
+		while (number > 0)
 		{
-			//Write a random byte
-			char r = rand() % 256;
-			outfile.write(&r, 1);
+			int count = (number < (int)sizeof(buffer)) ? number : (int)sizeof(buffer);
+			generator.fill(buffer, count);
+			outfile.write(buffer, count);
+			number -= count;
+		}
+	}
+}
+
+bool write_random_bytes(int fd, uint64_t numBytes, RandomDataGenerator* generator)
+{
+	//Use a large buffer aligned to the page size, as required for direct I/O
+	const size_t bufferSize = 4 * 1024 * 1024;
+	#ifdef _WIN32
+	char* buffer = (char*)_aligned_malloc(bufferSize, 4096);
+	#else
+	char* buffer = NULL;
+	if (posix_memalign((void**)&buffer, 4096, bufferSize) != 0) {
+		buffer = NULL;
+	}
+	#endif
+	
+	if (buffer == NULL) {
+		return false;
+	}
+	
+	bool success = true;
+	while (success && numBytes > 0)
+	{
+		size_t count = (numBytes < bufferSize) ? (size_t)numBytes : bufferSize;
+		if (generator != NULL) {
+			generator->fill(buffer, count);
+		}
+		else {
+			success = GenerateRandomBytes(buffer, count);
 		}
+		
+		success = success && write_buffers(fd, vector<string_view>(1, string_view(buffer, count)));
+		numBytes -= count;
+	}
+	
+	#ifdef _WIN32
+	_aligned_free(buffer);
+	#else
+	free(buffer);
+	#endif
+	
+	return success;
+}
+
+bool write_random_file(const string& path, uint64_t size, RandomDataGenerator* generator, bool directIO)
+{
+	PROFILE_ZONE("write_random_file");
+	
+	#ifdef _WIN32
+	
+	int fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY | _O_SEQUENTIAL, _S_IREAD | _S_IWRITE);
+	bool success = (fd != -1 && write_random_bytes(fd, size, generator));
+	if (fd != -1) {
+		success = (_close(fd) == 0) && success;
+	}
+	
+	return success;
+	
+	#else
+	
+	int flags = O_WRONLY | O_CREAT | O_TRUNC;
+	int fd = -1;
+	
+	#ifdef O_DIRECT
+	
+	//Not all filesystems support O_DIRECT (tmpfs, for example), so fall back to regular I/O if opening fails
+	if (directIO) {
+		fd = open(path.c_str(), flags | O_DIRECT, 0666);
+	}
+	
+	#endif
+	
+	if (fd == -1) {
+		fd = open(path.c_str(), flags, 0666);
+	}
+	
+	if (fd == -1) {
+		return false;
+	}
+	
+	#ifdef __APPLE__
+	if (directIO) {
+		fcntl(fd, F_NOCACHE, 1);
 	}
+	#endif
+	
+	#ifdef __linux__
+	
+	//Allocate the whole file up front, so that it is laid out contiguously where possible
+	if (size > 0) {
+		fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, size);
+	}
+	
+	#endif
+	
+	//Direct I/O requires block-sized writes, so the final partial block is written with direct I/O disabled
+	uint64_t aligned = size - (size % 4096);
+	bool success = write_random_bytes(fd, aligned, generator);
+	if (success && aligned < size)
+	{
+		#ifdef O_DIRECT
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+		#endif
+		
+		success = write_random_bytes(fd, size - aligned, generator);
+	}
+	
+	success = (close(fd) == 0) && success;
+	return success;
+	
+	#endif
+}
+
+bool write_sparse_file(const string& path, uint64_t size)
+{
+	#ifdef _WIN32
+	
+	int fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+	if (fd == -1) {
+		return false;
+	}
+	
+	bool success = (_chsize_s(fd, size) == 0);
+	return (_close(fd) == 0) && success;
+	
+	#else
+	
+	int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd == -1) {
+		return false;
+	}
+	
+	//Extending the file without writing leaves the entire file as a hole
+	bool success = (ftruncate(fd, size) == 0);
+	return (close(fd) == 0) && success;
+	
+	#endif
 }
 
 bool at_end(ifstream& stream)
@@ -207,31 +798,466 @@ size_t end_pos(ifstream& stream)
 	}
 }
 
+namespace
+{
+	//Normalises separators and strips any trailing separators (other than for the root directory)
+	string normalise_dir_path(const string& path)
+	{
+		string normalised = str_replace("\\", "/", path);
+		while (normalised.length() > 1 && normalised[normalised.length() - 1] == '/') {
+			normalised.resize(normalised.length() - 1);
+		}
+		
+		return normalised;
+	}
+	
+	#ifndef _WIN32
+	
+	//Opens the specified directory, creating it and any missing parents (returns -1 on failure)
+	int open_dir_creating(const string& path)
+	{
+		int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (fd != -1 || errno != ENOENT) {
+			return fd;
+		}
+		
+		//Walk backwards to find the deepest ancestor that already exists
+		size_t start = 0;
+		size_t end   = path.length();
+		while (fd == -1)
+		{
+			size_t slashPos = (end > 0) ? path.rfind('/', end - 1) : string::npos;
+			if (slashPos == string::npos)
+			{
+				//No ancestors exist, so start from the current directory
+				fd = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+				start = 0;
+				break;
+			}
+			
+			//A leading separator means we have reached the root directory
+			fd = open((slashPos == 0) ? "/" : path.substr(0, slashPos).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			if (fd == -1 && errno != ENOENT) {
+				return -1;
+			}
+			
+			start = slashPos + 1;
+			end   = slashPos;
+		}
+		
+		//Create each of the remaining components relative to its parent, which avoids resolving the full path each time
+		while (fd != -1 && start < path.length())
+		{
+			size_t slashPos = path.find('/', start);
+			if (slashPos == string::npos) {
+				slashPos = path.length();
+			}
+			
+			//Skip empty components caused by repeated separators
+			if (slashPos > start)
+			{
+				string component = path.substr(start, slashPos - start);
+				if (mkdirat(fd, component.c_str(), S_IRWXU | S_IRWXG | S_IRWXO) == -1 && errno != EEXIST)
+				{
+					close(fd);
+					return -1;
+				}
+				
+				int child = openat(fd, component.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+				close(fd);
+				fd = child;
+			}
+			
+			start = slashPos + 1;
+		}
+		
+		return fd;
+	}
+	
+	#endif
+	
+	//Orders paths so that each directory is immediately followed by its descendants
+	bool dir_path_order(const string& a, const string& b)
+	{
+		return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), [](char x, char y)
+		{
+			int xRank = (x == '/') ? -1 : (unsigned char)x;
+			int yRank = (y == '/') ? -1 : (unsigned char)y;
+			return xRank < yRank;
+		});
+	}
+	
+	//Creates a sorted run of leaf directories, reusing the descriptor for the parent directory across consecutive siblings
+	bool make_leaf_dirs(const vector<string>& leaves, size_t begin, size_t end)
+	{
+		bool success = true;
+		
+		#ifdef _WIN32
+		
+		for (size_t i = begin; i < end; ++i) {
+			success = make_dir(leaves[i]) && success;
+		}
+		
+		#else
+		
+		string parentPath;
+		int parentFd = -1;
+		for (size_t i = begin; i < end; ++i)
+		{
+			//Split the leaf into its parent directory and final component
+			const string& leaf = leaves[i];
+			size_t slashPos = leaf.rfind('/');
+			string parent = (slashPos == string::npos) ? string(".") : ((slashPos == 0) ? string("/") : leaf.substr(0, slashPos));
+			string name   = (slashPos == string::npos) ? leaf : leaf.substr(slashPos + 1);
+			
+			//Open (and if necessary create) the parent directory, unless it is the same as the previous leaf's
+			if (parentFd == -1 || parent != parentPath)
+			{
+				if (parentFd != -1) {
+					close(parentFd);
+				}
+				
+				parentFd   = open_dir_creating(parent);
+				parentPath = parent;
+			}
+			
+			if (parentFd == -1 || (!name.empty() && mkdirat(parentFd, name.c_str(), S_IRWXU | S_IRWXG | S_IRWXO) == -1 && errno != EEXIST)) {
+				success = false;
+			}
+		}
+		
+		if (parentFd != -1) {
+			close(parentFd);
+		}
+		
+		#endif
+		
+		return success;
+	}
+}
+
 bool make_dir(const string& path)
 {
-	//Break the path into directory components
-	vector<string> components = explode("/", str_replace("\\", "/", path));
+	string normalised = normalise_dir_path(path);
+	if (normalised.empty()) {
+		return false;
+	}
+	
+	#ifdef _WIN32
 	
-	//Iterate through the components (exclude the root directory/drive letter)
-	for (unsigned int i = 1; i < components.size(); ++i)
+	//Attempt to create each directory in the path (skipping the root directory/drive letter), ignoring those that already exist
+	for (size_t slashPos = normalised.find('/', 1); ; slashPos = normalised.find('/', slashPos + 1))
 	{
-		//Attempt to create each directory in the path if it does not exist
-		//Since the second argument to vector::vector is the end iterator, we add 1 to i, making the vector 0 to i inclusive
-		string currDir = implode("/", vector<string>(components.begin(), components.begin() + (i+1)));
-		if (!file_exists(currDir))
+		string currDir = normalised.substr(0, slashPos);
+		if (_mkdir(currDir.c_str()) == -1 && errno != EEXIST && !(errno == EACCES && is_dir(currDir))) {
+			return false;
+		}
+		
+		if (slashPos == string::npos) {
+			break;
+		}
+	}
+	
+	return true;
+	
+	#else
+	
+	//In the common case, the parent already exists and only a single call is needed
+	if (mkdir(normalised.c_str(), S_IRWXU | S_IRWXG | S_IRWXO) == 0) {
+		return true;
+	}
+	else if (errno == EEXIST) {
+		return is_dir(normalised);
+	}
+	else if (errno != ENOENT) {
+		return false;
+	}
+	
+	//Create the missing directories, starting from the deepest existing ancestor
+	int fd = open_dir_creating(normalised);
+	if (fd == -1) {
+		return false;
+	}
+	
+	close(fd);
+	return true;
+	
+	#endif
+}
+
+bool make_dirs(const vector<string>& paths, unsigned int threads)
+{
+	//Sort and deduplicate the paths, so that parents immediately precede their descendants
+	vector<string> sorted;
+	sorted.reserve(paths.size());
+	for (vector<string>::const_iterator currPath = paths.begin(); currPath != paths.end(); ++currPath)
+	{
+		string normalised = normalise_dir_path(*currPath);
+		if (!normalised.empty()) {
+			sorted.push_back(normalised);
+		}
+	}
+	
+	std::sort(sorted.begin(), sorted.end(), dir_path_order);
+	sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+	
+	//Discard any path that is a parent of the path following it, since creating the descendant will create the parent
+	vector<string> leaves;
+	leaves.reserve(sorted.size());
+	for (size_t i = 0; i < sorted.size(); ++i)
+	{
+		bool isParent = (i + 1 < sorted.size() && sorted[i + 1].length() > sorted[i].length() &&
+			sorted[i + 1].compare(0, sorted[i].length(), sorted[i]) == 0 && (sorted[i + 1][sorted[i].length()] == '/' || sorted[i] == "/"));
+		if (!isParent) {
+			leaves.push_back(sorted[i]);
+		}
+	}
+	
+	if (threads == 0) {
+		threads = std::thread::hardware_concurrency();
+	}
+	
+	//Small batches aren't worth the overhead of starting threads
+	size_t chunks = (leaves.size() + 255) / 256;
+	if (threads > chunks) {
+		threads = (unsigned int)chunks;
+	}
+	
+	if (threads <= 1) {
+		return make_leaf_dirs(leaves, 0, leaves.size());
+	}
+	
+	//Give each thread a contiguous run of leaves, so that each works within its own subtrees and siblings share a parent descriptor
+	//(where two threads need the same parent, the second simply finds that it already exists)
+	std::atomic<bool> success(true);
+	vector<std::thread> workers;
+	size_t perThread = (leaves.size() + threads - 1) / threads;
+	for (size_t begin = 0; begin < leaves.size(); begin += perThread)
+	{
+		size_t end = (begin + perThread < leaves.size()) ? begin + perThread : leaves.size();
+		workers.push_back(std::thread([&leaves, &success, begin, end]()
 		{
-			#ifdef _WIN32
-			if (_mkdir(currDir.c_str()) == -1)
-			#else
-			if (mkdir(currDir.c_str(), S_IRWXU | S_IRWXG | S_IRWXO) == -1)
-			#endif
+			if (!make_leaf_dirs(leaves, begin, end)) {
+				success = false;
+			}
+		}));
+	}
+	
+	for (vector<std::thread>::iterator currWorker = workers.begin(); currWorker != workers.end(); ++currWorker) {
+		currWorker->join();
+	}
+	
+	return success;
+}
+
+//MappedFile class
+
+#ifndef _WIN32
+namespace
+{
+	int madvise_flag(MappedFile::AccessHint hint)
+	{
+		switch (hint)
+		{
+			case MappedFile::Sequential: return MADV_SEQUENTIAL;
+			case MappedFile::Random:     return MADV_RANDOM;
+			case MappedFile::WillNeed:   return MADV_WILLNEED;
+			default:                     return MADV_NORMAL;
+		}
+	}
+}
+#endif
+
+MappedFile::MappedFile()
+{
+	this->address = NULL;
+	this->length  = 0;
+	this->opened  = false;
+	this->mode    = ReadOnly;
+	
+	this->fd      = -1;
+	
+	#ifdef _WIN32
+	this->mappingHandle = NULL;
+	#endif
+}
+
+MappedFile::MappedFile(const string& path, Mode mode, AccessHint hint)
+{
+	this->address = NULL;
+	this->length  = 0;
+	this->opened  = false;
+	this->mode    = ReadOnly;
+	
+	this->fd      = -1;
+	
+	#ifdef _WIN32
+	this->mappingHandle = NULL;
+	#endif
+	
+	this->open(path, mode, hint);
+}
+
+MappedFile::~MappedFile() {
+	this->close();
+}
+
+bool MappedFile::open(const string& path, Mode mode, AccessHint hint)
+{
+	//If a file is currently mapped, close it
+	this->close();
+	
+	#ifdef _WIN32
+	
+		//Under Windows, the sequential and random hints can only be supplied when the file is opened
+		int flags = (mode == ReadWrite) ? (_O_RDWR | _O_BINARY) : (_O_RDONLY | _O_BINARY);
+		if (hint == Sequential) flags |= _O_SEQUENTIAL;
+		if (hint == Random)     flags |= _O_RANDOM;
+		
+		//Attempt to open the file and determine its size (the descriptor owns the underlying handle)
+		int fd = _open(path.c_str(), flags);
+		if (fd == -1) {
+			return false;
+		}
+		
+		HANDLE file = (HANDLE)_get_osfhandle(fd);
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize))
+		{
+			_close(fd);
+			return false;
+		}
+		
+		//Empty files cannot be mapped, so we simply leave the data pointer as NULL
+		if (fileSize.QuadPart > 0)
+		{
+			HANDLE mapping = CreateFileMappingA(file, NULL, (mode == ReadWrite) ? PAGE_READWRITE : PAGE_READONLY, 0, 0, NULL);
+			void* address = (mapping != NULL) ? MapViewOfFile(mapping, (mode == ReadWrite) ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0) : NULL;
+			if (address == NULL)
+			{
+				if (mapping != NULL) CloseHandle(mapping);
+				_close(fd);
+				return false;
+			}
+			
+			this->mappingHandle = mapping;
+			this->address       = (char*)address;
+			this->length        = (size_t)fileSize.QuadPart;
+		}
+		
+		this->fd = fd;
+	
+	#else
+	
+		//Attempt to open the file and determine its size
+		int fd = ::open(path.c_str(), (mode == ReadWrite) ? O_RDWR : O_RDONLY);
+		if (fd == -1) {
+			return false;
+		}
+		
+		struct stat fileInfo;
+		if (fstat(fd, &fileInfo) != 0 || !S_ISREG(fileInfo.st_mode))
+		{
+			::close(fd);
+			return false;
+		}
+		
+		//Empty files cannot be mapped, so we simply leave the data pointer as NULL
+		if (fileInfo.st_size > 0)
+		{
+			int protection = (mode == ReadWrite) ? (PROT_READ | PROT_WRITE) : PROT_READ;
+			int flags      = (mode == ReadWrite) ? MAP_SHARED : MAP_PRIVATE;
+			void* address  = mmap(NULL, fileInfo.st_size, protection, flags, fd, 0);
+			if (address == MAP_FAILED)
 			{
+				::close(fd);
 				return false;
 			}
+			
+			this->address = (char*)address;
+			this->length  = fileInfo.st_size;
 		}
+		
+		this->fd = fd;
+	
+	#endif
+	
+	this->opened = true;
+	this->mode   = mode;
+	
+	//Apply the access hint (the hint is purely advisory, so failure does not affect the mapping)
+	if (hint != Normal) {
+		this->advise(hint);
 	}
 	
-	//All directories successfully created
 	return true;
 }
 
+void MappedFile::close()
+{
+	#ifdef _WIN32
+	
+		if (this->address != NULL) UnmapViewOfFile(this->address);
+		if (this->mappingHandle != NULL) CloseHandle(this->mappingHandle);
+		if (this->fd != -1) _close(this->fd);
+		this->mappingHandle = NULL;
+		this->fd            = -1;
+	
+	#else
+	
+		if (this->address != NULL) munmap(this->address, this->length);
+		if (this->fd != -1) ::close(this->fd);
+		this->fd = -1;
+	
+	#endif
+	
+	this->address = NULL;
+	this->length  = 0;
+	this->opened  = false;
+	this->mode    = ReadOnly;
+}
+
+bool MappedFile::advise(AccessHint hint, size_t offset, size_t length)
+{
+	if (this->address == NULL || offset >= this->length) {
+		return false;
+	}
+	
+	#ifdef _WIN32
+	
+		//Windows only accepts access hints when the file is opened
+		return true;
+	
+	#else
+	
+		//madvise() requires a page-aligned start address
+		size_t pageSize = sysconf(_SC_PAGESIZE);
+		size_t alignedOffset = offset - (offset % pageSize);
+		size_t end = (length == 0 || length > this->length - offset) ? this->length : offset + length;
+		return (madvise(this->address + alignedOffset, end - alignedOffset, madvise_flag(hint)) == 0);
+	
+	#endif
+}
+
+bool MappedFile::sync(bool wait)
+{
+	if (this->address == NULL || this->mode != ReadWrite) {
+		return this->opened;
+	}
+	
+	#ifdef _WIN32
+		return (FlushViewOfFile(this->address, 0) && (!wait || FlushFileBuffers((HANDLE)_get_osfhandle(this->fd))));
+	#else
+		return (msync(this->address, this->length, (wait) ? MS_SYNC : MS_ASYNC) == 0);
+	#endif
+}
+
+string_view MappedFile::view(size_t offset, size_t count) const
+{
+	if (offset >= this->length) {
+		return string_view();
+	}
+	
+	size_t available = this->length - offset;
+	return string_view(this->address + offset, (count < available) ? count : available);
+}
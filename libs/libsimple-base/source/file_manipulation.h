@@ -36,12 +36,18 @@
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <string_view>
+#include <vector>
+#include <stdint.h>
 #include <sys/stat.h>
+#include "random.h"
 using std::string;
+using std::string_view;
 using std::ifstream;
 using std::ofstream;
 using std::ios;
 using std::stringstream;
+using std::vector;
 
 //Implementations of PHP Functions (std::string is utilised in a binary-safe manner when dealing with data)
 string file_get_contents  (const string& path);
@@ -50,10 +56,129 @@ bool   is_dir             (const string& path);
 off_t  filesize           (const string& path);
 bool   file_put_contents  (const string& path, const string& data);
 
+//Options for the extended versions of file_put_contents()
+struct FileWriteOptions
+{
+	enum SyncMode
+	{
+		NoSync,    //Leave flushing to the operating system (the behaviour of the two-argument version)
+		SyncData,  //Flush the file data using fdatasync() before returning
+		SyncAll    //Flush the file data and metadata using fsync() before returning
+	};
+	
+	bool     atomic;       //Write to a temporary file alongside the target and rename() it into place, so the target is never left partially written
+	bool     preallocate;  //Reserve the full size of the file with fallocate() before writing (Linux only, ignored elsewhere)
+	SyncMode sync;         //When writing atomically, the parent directory is also synced so that the rename is durable
+	
+	FileWriteOptions() : atomic(false), preallocate(false), sync(NoSync) {}
+};
+
+//Extended versions of file_put_contents(), the second of which writes several buffers in order using writev() (avoiding the need to concatenate them first)
+bool file_put_contents(const string& path, const string& data, const FileWriteOptions& options);
+bool file_put_contents(const string& path, const vector<string_view>& buffers, const FileWriteOptions& options = FileWriteOptions());
+
+//Writes all of the supplied data to a file descriptor, retrying for partial writes (such as to pipes) and interrupts.
+//Returns false if an error occurred, in which case some of the data may have been written.
+bool write_all(int fd, const char* data, size_t length);
+
+//The mechanisms that copy_range() can use, in the order they are attempted
+enum CopyRangeMethod
+{
+	COPY_RANGE_NONE,             //No data was copied
+	COPY_RANGE_REFLINK,          //The range was cloned using the FICLONERANGE ioctl (copy-on-write filesystems such as Btrfs and XFS)
+	COPY_RANGE_COPY_FILE_RANGE,  //The kernel copied the data using copy_file_range()
+	COPY_RANGE_SENDFILE,         //The kernel copied the data using sendfile()
+	COPY_RANGE_BUFFERED          //The data was copied through a userspace buffer
+};
+
+//Copies up to length bytes from srcFd (starting at srcOffset) to dstFd (starting at dstOffset), using the fastest mechanism available.
+//Passing -1 for dstOffset writes at (and advances) the current file offset of dstFd, which also allows dstFd to be a pipe or socket.
+//Returns the number of bytes copied (less than length if the end of the source was reached), or -1 if an error occurred.
+//If method is not NULL, it receives the mechanism that copied the data (the last one used, if a mechanism failed partway through).
+int64_t copy_range(int srcFd, int64_t srcOffset, int dstFd, int64_t dstOffset, int64_t length, CopyRangeMethod* method = NULL);
+
 time_t    file_last_modified (const string& path);            //Returns the last-modified timestamp of the specified file
 void      write_random_bytes (ofstream& outfile, int number); //Writes the specified number of random bytes to the supplied ofstream.
 bool      at_end             (ifstream& stream);              //Checks if the read pointer for the supplied stream is at the end
 size_t    end_pos            (ifstream& stream);              //Retrieves the end position of the supplied stream
 bool      make_dir           (const string& path);            //Creates a directory, creating parent directories as needed
 
+//Writes the specified number of random bytes to a file descriptor, generating them one large buffer at a time.
+//If generator is NULL, the cryptographically-secure GenerateRandomBytes() is used, otherwise the (much faster) supplied generator is used.
+bool write_random_bytes(int fd, uint64_t numBytes, RandomDataGenerator* generator = NULL);
+
+//Creates a file of the specified size filled with random data (see above). If directIO is true, the data bypasses the page cache
+//(O_DIRECT under Linux, F_NOCACHE under OSX) so that generating large test fixtures does not evict other cached data.
+bool write_random_file(const string& path, uint64_t size, RandomDataGenerator* generator = NULL, bool directIO = false);
+
+//Creates a file of the specified size that contains no data (a sparse file, on filesystems that support them)
+bool write_sparse_file(const string& path, uint64_t size);
+
+//Creates each of the specified directories (and their parents), splitting the work across the specified number of threads (zero means one per core).
+//Duplicate paths and paths that are parents of other paths are only processed once. Programs using this function must be linked with -pthread.
+bool make_dirs(const vector<string>& paths, unsigned int threads = 0);
+
+//RAII wrapper for a memory-mapped file, using mmap() under POSIX systems and MapViewOfFile() under Windows.
+//The file descriptor remains open for the lifetime of the mapping, and can be retrieved using descriptor().
+//Empty files are considered to be open, with a size of zero and NULL data.
+class MappedFile
+{
+	public:
+		enum Mode
+		{
+			ReadOnly,
+			ReadWrite
+		};
+		
+		//These correspond to the MADV_* flags for madvise()
+		enum AccessHint
+		{
+			Normal,
+			Sequential,
+			Random,
+			WillNeed
+		};
+		
+		MappedFile();
+		explicit MappedFile(const string& path, Mode mode = ReadOnly, AccessHint hint = Normal);
+		~MappedFile();
+		
+		//Maps the specified file, closing any existing mapping first
+		bool open(const string& path, Mode mode = ReadOnly, AccessHint hint = Normal);
+		
+		//Unmaps the file and closes the file descriptor
+		void close();
+		
+		//Applies an access hint to the specified range (a length of zero means to the end of the file)
+		bool advise(AccessHint hint, size_t offset = 0, size_t length = 0);
+		
+		//Flushes changes to a read-write mapping back to the file
+		bool sync(bool wait = true);
+		
+		bool        isOpen()       const { return this->opened; }
+		const char* data()         const { return this->address; }
+		char*       writableData() const { return (this->mode == ReadWrite) ? this->address : NULL; }
+		size_t      size()         const { return this->length; }
+		string_view view()         const { return string_view(this->address, this->length); }
+		int         descriptor()   const { return this->fd; }
+		
+		//Retrieves a view of the specified range, clipped to the end of the file
+		string_view view(size_t offset, size_t count) const;
+	
+	private:
+		//Copying would result in a double unmap
+		MappedFile(const MappedFile& other);
+		MappedFile& operator=(const MappedFile& other);
+		
+		char*  address;
+		size_t length;
+		bool   opened;
+		Mode   mode;
+		int    fd;
+		
+		#ifdef _WIN32
+		void* mappingHandle;
+		#endif
+};
+
 #endif
@@ -31,22 +31,79 @@
 //We need these for globbing and vector merging
 #include "array_manipulation.h"
 #include "environment.h"
+#include "DirectoryWalker.h"
+#include "file_manipulation.h"
+#include "string_manipulation.h"
+
+#include <algorithm>
 
 vector<string> expandWildcards(const string& pattern)
 {
-	//Check to see if the pattern string contains any wildcards
-	if (pattern.find("*") != string::npos)
+	//Patterns of the form "dir/**/pattern" match files in the directory and all of its subdirectories
+	size_t recursivePos = pattern.find("**/");
+	if (recursivePos != string::npos && (recursivePos == 0 || pattern[recursivePos - 1] == '/'))
 	{
-		//Return the result of globbing the pattern
-		return glob(pattern);
+		string root = (recursivePos == 0) ? "." : pattern.substr(0, (recursivePos > 1) ? recursivePos - 1 : 1);
+		string tail = pattern.substr(recursivePos + 3);
+		vector<string> results;
+		
+		if (tail.find('/') == string::npos)
+		{
+			WalkOptions options;
+			options.include.push_back(tail);
+			results = walk_directory(root, options);
+		}
+		else
+		{
+			//Since ** matches any number of directories, a tail containing slashes must match the same number of trailing path components
+			int numComponents = (int)std::count(tail.begin(), tail.end(), '/') + 1;
+			walk_directory(root, [&results, &tail, numComponents](const WalkEntry& entry) -> bool
+			{
+				if (entry.isDirectory || entry.depth < numComponents) {
+					return true;
+				}
+				
+				size_t suffixPos = entry.path.length();
+				for (int i = 0; i < numComponents; ++i) {
+					suffixPos = entry.path.rfind('/', suffixPos - 1);
+				}
+				
+				if (wildcard_match(tail, entry.path.substr(suffixPos + 1))) {
+					results.push_back(entry.path);
+				}
+				
+				return true;
+			});
+			
+			std::sort(results.begin(), results.end());
+		}
+		
+		//Patterns relative to the current directory produce paths without a leading "./", as glob() does
+		if (recursivePos == 0)
+		{
+			for (vector<string>::iterator result = results.begin(); result != results.end(); ++result) {
+				result->erase(0, 2);
+			}
+		}
+		
+		return results;
 	}
-	else
+	
+	//Check to see if the pattern string contains any wildcards
+	if (pattern.find_first_of("*?[") != string::npos)
 	{
-		//Return a vector containing the pattern
-		vector<string> result;
-		result.push_back(pattern);
-		return result;
+		//Return the result of globbing the pattern, unless nothing matched and the pattern contains only ? or [ (which are valid
+		//in filenames), in which case the pattern is passed through so that the caller can report that the file does not exist
+		vector<string> results = glob(pattern);
+		if (!results.empty() || pattern.find('*') != string::npos) {
+			return results;
+		}
 	}
+	
+	//Return a vector containing the pattern
+	vector<string> result;
+	result.push_back(pattern);
+	return result;
 }
 
 vector<string> gatherInputFiles(int argc, char* argv[], const string& infileDelim)
@@ -0,0 +1,535 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  Profiling Zones
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "profiling.h"
+#include "environment.h"
+#include "file_manipulation.h"
+#include "StringBuilder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+using std::map;
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include <process.h>
+#else
+	#include <unistd.h>
+	
+	#ifdef __linux__
+		#include <sys/syscall.h>
+	#endif
+#endif
+
+//The maximum length of the detail string stored with each span (including the terminator)
+#define TRACING_DETAIL_LENGTH 96
+
+//Each power of two is divided into 2^PROFILING_SUB_BUCKET_BITS linear sub-buckets
+#define PROFILING_SUB_BUCKET_BITS 4
+#define PROFILING_SUB_BUCKETS (1 << PROFILING_SUB_BUCKET_BITS)
+#define PROFILING_NUM_BUCKETS ((64 - PROFILING_SUB_BUCKET_BITS + 1) * PROFILING_SUB_BUCKETS)
+
+namespace
+{
+	//The histogram for a single zone in a single thread. Only the owning thread ever writes to it, so updates are
+	//plain loads and stores (rather than atomic read-modify-write operations), and other threads can read it at any time.
+	struct ZoneHistogram
+	{
+		std::atomic<uint64_t> buckets[PROFILING_NUM_BUCKETS];
+		std::atomic<uint64_t> count;
+		std::atomic<int64_t> total;
+		std::atomic<int64_t> max;
+		
+		ZoneHistogram() : count(0), total(0), max(0)
+		{
+			for (int i = 0; i < PROFILING_NUM_BUCKETS; ++i) {
+				this->buckets[i].store(0, std::memory_order_relaxed);
+			}
+		}
+	};
+	
+	//A single span recorded while tracing
+	struct TraceEvent
+	{
+		int zone;
+		uint32_t threadId;
+		int64_t startTime;
+		int64_t duration;
+		char detail[TRACING_DETAIL_LENGTH];
+	};
+	
+	//The ring buffer of spans for a single thread. The lock is only contended while the trace is being written.
+	struct TraceRing
+	{
+		std::mutex lock;
+		vector<TraceEvent> events;
+		uint64_t numWritten;
+		
+		TraceRing(size_t capacity) : events(capacity), numWritten(0) {}
+	};
+	
+	//The histograms and spans belonging to a single thread (which are reused by a later thread once the owner exits)
+	struct ThreadHistograms
+	{
+		std::atomic<ZoneHistogram*> zones[PROFILING_MAX_ZONES];
+		std::atomic<TraceRing*> ring;
+		uint32_t threadId;
+		bool inUse;
+		
+		ThreadHistograms() : ring(NULL), threadId(0), inUse(true)
+		{
+			for (int i = 0; i < PROFILING_MAX_ZONES; ++i) {
+				this->zones[i].store(NULL, std::memory_order_relaxed);
+			}
+		}
+	};
+	
+	//The global registry of zone names and per-thread histograms (these are never freed, so they can be read without locking)
+	struct ProfilingRegistry
+	{
+		std::mutex lock;
+		map<string, int> zoneIds;
+		vector<string> zoneNames;
+		std::atomic<ThreadHistograms*> threads[1024];
+		std::atomic<int> numThreads;
+		std::atomic<bool> tracing;
+		std::atomic<size_t> ringCapacity;
+		int64_t traceStartTime;
+		
+		ProfilingRegistry() : numThreads(0), tracing(false), ringCapacity(0), traceStartTime(0) {}
+	};
+	
+	ProfilingRegistry& registry()
+	{
+		//Intentionally leaked, so that threads exiting during static destruction can still record
+		static ProfilingRegistry* instance = new ProfilingRegistry();
+		return *instance;
+	}
+	
+	//Marks the current thread's histograms as available for reuse when the thread exits
+	struct ThreadHistogramsHandle
+	{
+		ThreadHistograms* histograms;
+		
+		ThreadHistogramsHandle() : histograms(NULL) {}
+		
+		~ThreadHistogramsHandle()
+		{
+			if (this->histograms != NULL)
+			{
+				std::lock_guard<std::mutex> lock(registry().lock);
+				this->histograms->inUse = false;
+			}
+		}
+	};
+	
+	//Retrieves the operating system's identifier for the current thread, for labelling spans
+	uint32_t current_thread_id()
+	{
+		#if defined(_WIN32)
+		return (uint32_t)GetCurrentThreadId();
+		#elif defined(__linux__)
+		return (uint32_t)syscall(SYS_gettid);
+		#else
+		static std::atomic<uint32_t> nextId(1);
+		return nextId++;
+		#endif
+	}
+	
+	//Retrieves the histograms for the current thread, allocating (or reusing) them on first use
+	ThreadHistograms* current_thread_histograms()
+	{
+		static thread_local ThreadHistogramsHandle handle;
+		if (handle.histograms != NULL) {
+			return handle.histograms;
+		}
+		
+		uint32_t threadId = current_thread_id();
+		ProfilingRegistry& reg = registry();
+		std::lock_guard<std::mutex> lock(reg.lock);
+		int numThreads = reg.numThreads.load(std::memory_order_relaxed);
+		for (int i = 0; i < numThreads; ++i)
+		{
+			ThreadHistograms* existing = reg.threads[i].load(std::memory_order_relaxed);
+			if (!existing->inUse)
+			{
+				existing->inUse = true;
+				existing->threadId = threadId;
+				handle.histograms = existing;
+				return existing;
+			}
+		}
+		
+		//If the thread table is full, the thread's durations are not recorded
+		if (numThreads == (int)(sizeof(reg.threads) / sizeof(reg.threads[0]))) {
+			return NULL;
+		}
+		
+		handle.histograms = new ThreadHistograms();
+		handle.histograms->threadId = threadId;
+		reg.threads[numThreads].store(handle.histograms, std::memory_order_release);
+		reg.numThreads.store(numThreads + 1, std::memory_order_release);
+		return handle.histograms;
+	}
+	
+	//Maps a duration to its histogram bucket
+	int bucket_for_value(uint64_t value)
+	{
+		if (value < PROFILING_SUB_BUCKETS) {
+			return (int)value;
+		}
+		
+		int exponent = 63;
+		while (!(value & ((uint64_t)1 << exponent))) {
+			exponent--;
+		}
+		
+		int subBucket = (int)((value >> (exponent - PROFILING_SUB_BUCKET_BITS)) & (PROFILING_SUB_BUCKETS - 1));
+		return ((exponent - PROFILING_SUB_BUCKET_BITS + 1) * PROFILING_SUB_BUCKETS) + subBucket;
+	}
+	
+	//Retrieves the value at the midpoint of a histogram bucket
+	int64_t value_for_bucket(int bucket)
+	{
+		if (bucket < PROFILING_SUB_BUCKETS) {
+			return bucket;
+		}
+		
+		int shift = (bucket / PROFILING_SUB_BUCKETS) - 1;
+		uint64_t lowest = (uint64_t)(PROFILING_SUB_BUCKETS + (bucket % PROFILING_SUB_BUCKETS)) << shift;
+		uint64_t width = (uint64_t)1 << shift;
+		return (int64_t)(lowest + (width / 2));
+	}
+	
+	//Finds the value below which the specified fraction of the recorded durations fall
+	int64_t percentile(const vector<uint64_t>& buckets, uint64_t count, double fraction, int64_t max)
+	{
+		uint64_t target = (uint64_t)((double)count * fraction);
+		if (target == 0) {
+			target = 1;
+		}
+		
+		uint64_t seen = 0;
+		for (size_t i = 0; i < buckets.size(); ++i)
+		{
+			seen += buckets[i];
+			if (seen >= target) {
+				return std::min(value_for_bucket((int)i), max);
+			}
+		}
+		
+		return max;
+	}
+	
+	//Appends a span to the current thread's ring buffer, overwriting the oldest span once the buffer is full
+	void record_span(ThreadHistograms* histograms, int zone, int64_t startTime, int64_t duration, const char* detail)
+	{
+		TraceRing* ring = histograms->ring.load(std::memory_order_acquire);
+		if (ring == NULL)
+		{
+			ring = new TraceRing(registry().ringCapacity.load(std::memory_order_relaxed));
+			histograms->ring.store(ring, std::memory_order_release);
+		}
+		
+		std::lock_guard<std::mutex> lock(ring->lock);
+		if (ring->events.empty()) {
+			return;
+		}
+		
+		TraceEvent& event = ring->events[ring->numWritten % ring->events.size()];
+		event.zone = zone;
+		event.threadId = histograms->threadId;
+		event.startTime = startTime;
+		event.duration = duration;
+		event.detail[0] = 0;
+		if (detail != NULL)
+		{
+			strncpy(event.detail, detail, TRACING_DETAIL_LENGTH - 1);
+			event.detail[TRACING_DETAIL_LENGTH - 1] = 0;
+		}
+		
+		ring->numWritten++;
+	}
+	
+	//Appends a string to a JSON document as a quoted and escaped string literal
+	void append_json_string(StringBuilder& json, const string& value)
+	{
+		json.append('"');
+		for (size_t i = 0; i < value.length(); ++i)
+		{
+			unsigned char c = (unsigned char)value[i];
+			if (c == '"' || c == '\\')
+			{
+				json.append('\\');
+				json.append((char)c);
+			}
+			else if (c < 0x20)
+			{
+				char escaped[8];
+				snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+				json.append(escaped);
+			}
+			else {
+				json.append((char)c);
+			}
+		}
+		
+		json.append('"');
+	}
+	
+	//Writes the trace to the path specified by the SIMPLE_BASE_TRACE environment variable
+	void write_trace_at_exit() {
+		tracing_write(get_env("SIMPLE_BASE_TRACE"));
+	}
+	
+	//Starts tracing when the program starts if the SIMPLE_BASE_TRACE environment variable is set
+	bool start_tracing_from_environment()
+	{
+		if (get_env("SIMPLE_BASE_TRACE").empty()) {
+			return false;
+		}
+		
+		tracing_start();
+		atexit(write_trace_at_exit);
+		return true;
+	}
+	
+	bool tracingFromEnvironment = start_tracing_from_environment();
+}
+
+int profiling_register_zone(const char* name)
+{
+	ProfilingRegistry& reg = registry();
+	std::lock_guard<std::mutex> lock(reg.lock);
+	map<string, int>::iterator existing = reg.zoneIds.find(name);
+	if (existing != reg.zoneIds.end()) {
+		return existing->second;
+	}
+	
+	if (reg.zoneNames.size() == PROFILING_MAX_ZONES) {
+		return -1;
+	}
+	
+	int zone = (int)reg.zoneNames.size();
+	reg.zoneIds[name] = zone;
+	reg.zoneNames.push_back(name);
+	return zone;
+}
+
+void profiling_record(int zone, int64_t startTime, int64_t nanoseconds, const char* detail)
+{
+	ThreadHistograms* histograms = current_thread_histograms();
+	if (zone < 0 || histograms == NULL) {
+		return;
+	}
+	
+	if (registry().tracing.load(std::memory_order_relaxed)) {
+		record_span(histograms, zone, startTime, nanoseconds, detail);
+	}
+	
+	//Allocate the histogram for the zone the first time the current thread exits it
+	ZoneHistogram* histogram = histograms->zones[zone].load(std::memory_order_relaxed);
+	if (histogram == NULL)
+	{
+		histogram = new ZoneHistogram();
+		histograms->zones[zone].store(histogram, std::memory_order_release);
+	}
+	
+	if (nanoseconds < 0) {
+		nanoseconds = 0;
+	}
+	
+	std::atomic<uint64_t>& bucket = histogram->buckets[bucket_for_value((uint64_t)nanoseconds)];
+	bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	histogram->total.store(histogram->total.load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+	if (nanoseconds > histogram->max.load(std::memory_order_relaxed)) {
+		histogram->max.store(nanoseconds, std::memory_order_relaxed);
+	}
+	
+	histogram->count.store(histogram->count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+vector<ProfileZoneStats> profiling_snapshot()
+{
+	ProfilingRegistry& reg = registry();
+	vector<string> zoneNames;
+	{
+		std::lock_guard<std::mutex> lock(reg.lock);
+		zoneNames = reg.zoneNames;
+	}
+	
+	//Merge the histograms of every thread for each zone
+	vector<ProfileZoneStats> snapshot;
+	vector<uint64_t> buckets(PROFILING_NUM_BUCKETS);
+	int numThreads = reg.numThreads.load(std::memory_order_acquire);
+	for (size_t zone = 0; zone < zoneNames.size(); ++zone)
+	{
+		ProfileZoneStats stats;
+		stats.name = zoneNames[zone];
+		stats.count = 0;
+		stats.total = 0;
+		stats.max = 0;
+		std::fill(buckets.begin(), buckets.end(), 0);
+		
+		for (int thread = 0; thread < numThreads; ++thread)
+		{
+			ZoneHistogram* histogram = reg.threads[thread].load(std::memory_order_acquire)->zones[zone].load(std::memory_order_acquire);
+			if (histogram != NULL)
+			{
+				stats.total += histogram->total.load(std::memory_order_relaxed);
+				stats.max = std::max(stats.max, histogram->max.load(std::memory_order_relaxed));
+				for (int i = 0; i < PROFILING_NUM_BUCKETS; ++i)
+				{
+					uint64_t bucketCount = histogram->buckets[i].load(std::memory_order_relaxed);
+					buckets[i] += bucketCount;
+					stats.count += bucketCount;
+				}
+			}
+		}
+		
+		//The count is derived from the buckets, so that it is consistent with the percentiles even if threads are recording concurrently
+		if (stats.count > 0)
+		{
+			stats.p50 = percentile(buckets, stats.count, 0.50, stats.max);
+			stats.p90 = percentile(buckets, stats.count, 0.90, stats.max);
+			stats.p99 = percentile(buckets, stats.count, 0.99, stats.max);
+			snapshot.push_back(stats);
+		}
+	}
+	
+	return snapshot;
+}
+
+string profiling_report(const vector<ProfileZoneStats>& snapshot)
+{
+	StringBuilder report;
+	char line[512];
+	snprintf(line, sizeof(line), "%-32s %10s %12s %10s %10s %10s %10s\n", "Zone", "Count", "Total (us)", "p50", "p90", "p99", "Max");
+	report.append(line);
+	for (vector<ProfileZoneStats>::const_iterator zone = snapshot.begin(); zone != snapshot.end(); ++zone)
+	{
+		snprintf(line, sizeof(line), "%-32s %10llu %12.1f %10.1f %10.1f %10.1f %10.1f\n",
+			zone->name.c_str(),
+			(unsigned long long)zone->count,
+			(double)zone->total / 1000.0,
+			(double)zone->p50 / 1000.0,
+			(double)zone->p90 / 1000.0,
+			(double)zone->p99 / 1000.0,
+			(double)zone->max / 1000.0
+		);
+		report.append(line);
+	}
+	
+	return report.str();
+}
+
+void tracing_start(size_t eventsPerThread)
+{
+	ProfilingRegistry& reg = registry();
+	std::lock_guard<std::mutex> lock(reg.lock);
+	if (reg.traceStartTime == 0) {
+		reg.traceStartTime = nanotime();
+	}
+	
+	reg.ringCapacity.store(eventsPerThread, std::memory_order_relaxed);
+	reg.tracing.store(true, std::memory_order_relaxed);
+}
+
+void tracing_stop() {
+	registry().tracing.store(false, std::memory_order_relaxed);
+}
+
+bool tracing_active() {
+	return registry().tracing.load(std::memory_order_relaxed);
+}
+
+bool tracing_write(const string& path)
+{
+	ProfilingRegistry& reg = registry();
+	vector<string> zoneNames;
+	int64_t traceStartTime = 0;
+	{
+		std::lock_guard<std::mutex> lock(reg.lock);
+		zoneNames = reg.zoneNames;
+		traceStartTime = reg.traceStartTime;
+	}
+	
+	//Copy the spans out of each thread's ring buffer, holding its lock only while copying
+	vector<TraceEvent> events;
+	int numThreads = reg.numThreads.load(std::memory_order_acquire);
+	for (int thread = 0; thread < numThreads; ++thread)
+	{
+		TraceRing* ring = reg.threads[thread].load(std::memory_order_acquire)->ring.load(std::memory_order_acquire);
+		if (ring != NULL && !ring->events.empty())
+		{
+			std::lock_guard<std::mutex> lock(ring->lock);
+			uint64_t capacity = ring->events.size();
+			uint64_t first = (ring->numWritten > capacity) ? ring->numWritten - capacity : 0;
+			for (uint64_t i = first; i < ring->numWritten; ++i) {
+				events.push_back(ring->events[i % capacity]);
+			}
+		}
+	}
+	
+	//Generate the JSON using complete ("X") events, with timestamps in microseconds relative to when tracing started
+	#ifdef _WIN32
+	int processId = _getpid();
+	#else
+	int processId = getpid();
+	#endif
+	
+	StringBuilder json;
+	json.append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	char numbers[128];
+	for (size_t i = 0; i < events.size(); ++i)
+	{
+		const TraceEvent& event = events[i];
+		json.append("{\"name\":");
+		append_json_string(json, (event.zone < (int)zoneNames.size()) ? zoneNames[event.zone] : "");
+		snprintf(numbers, sizeof(numbers), ",\"cat\":\"simple-base\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u",
+			(double)(event.startTime - traceStartTime) / 1000.0,
+			(double)event.duration / 1000.0,
+			processId,
+			event.threadId
+		);
+		json.append(numbers);
+		
+		if (event.detail[0] != 0)
+		{
+			json.append(",\"args\":{\"detail\":");
+			append_json_string(json, event.detail);
+			json.append('}');
+		}
+		
+		json.append((i + 1 < events.size()) ? "},\n" : "}\n");
+	}
+	
+	json.append("]}\n");
+	return file_put_contents(path, json.str());
+}
@@ -0,0 +1,141 @@
+/*
+//  Simple Base Library for C++ (libsimple-base)
+//  Copyright (c) 2009-2013, Adam Rehn
+//
+//  ---
+//
+//  Profiling Zones
+//
+//  Lightweight instrumentation for measuring where time is spent. A zone is
+//  a named scope, and each time a zone is exited its duration is recorded
+//  in a histogram belonging to the current thread, so recording never takes
+//  a lock or contends with other threads. profiling_snapshot() merges the
+//  histograms of all threads (without blocking them) and reports the count,
+//  percentiles and maximum duration of each zone.
+//  
+//  In order to enable profiling, either use the preprocessor directive
+//  
+//  #define PROFILING
+//  
+//  prior to the inclusion of this header file, or add "-D PROFILING" to the
+//  compiler options during compilation. Otherwise, the PROFILE_ZONE() macro
+//  compiles to nothing. The library's own zones (checksums, file I/O and
+//  process spawning) are only recorded if the library itself was compiled
+//  with PROFILING defined (for example, "CXXFLAGS=-DPROFILING make").
+//  
+//  Histograms use 16 linear sub-buckets per power of two, so reported
+//  durations are accurate to within around 6%.
+//  
+//  While tracing is active, each zone is also recorded as a span in a ring
+//  buffer belonging to the current thread (so only the most recent spans
+//  are kept), and tracing_write() exports the spans of all threads as Chrome
+//  trace event JSON, which can be loaded into Perfetto or chrome://tracing
+//  to visualise concurrency and stalls. Setting the SIMPLE_BASE_TRACE
+//  environment variable to a path starts tracing when the program starts
+//  and writes the trace to that path when it exits.
+//
+//  ---
+//
+//  This file is part of the Simple Base Library for C++ (libsimple-base).
+//
+//  libsimple-base is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published
+//  by the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _LIB_SIMPLE_BASE_PROFILING_H
+#define _LIB_SIMPLE_BASE_PROFILING_H
+
+#include "time.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+//The maximum number of distinct zones (zones registered beyond this limit are not recorded)
+#define PROFILING_MAX_ZONES 256
+
+struct ProfileZoneStats
+{
+	string   name;
+	uint64_t count;     //The number of times the zone was exited
+	int64_t  total;     //The total time spent in the zone, in nanoseconds
+	int64_t  p50;       //The median duration, in nanoseconds
+	int64_t  p90;       //The 90th percentile duration, in nanoseconds
+	int64_t  p99;       //The 99th percentile duration, in nanoseconds
+	int64_t  max;       //The longest duration, in nanoseconds
+};
+
+//Retrieves the statistics for every zone that has been recorded at least once, merged across all threads
+vector<ProfileZoneStats> profiling_snapshot();
+
+//Formats a snapshot as a human-readable table (with durations in microseconds)
+string profiling_report(const vector<ProfileZoneStats>& snapshot);
+
+//Registers a zone name (or retrieves the existing identifier for it), returning -1 if the zone limit has been reached
+int profiling_register_zone(const char* name);
+
+//Records a single duration for the specified zone in the current thread's histogram (and as a span, if tracing is active).
+//The detail string (such as a command or path) is only used for the span, and is truncated to 95 characters.
+void profiling_record(int zone, int64_t startTime, int64_t duration, const char* detail = NULL);
+
+//Starts recording spans, keeping the most recent eventsPerThread spans for each thread
+void tracing_start(size_t eventsPerThread = 65536);
+
+//Stops recording spans (the spans recorded so far are kept)
+void tracing_stop();
+
+//Determines if spans are being recorded
+bool tracing_active();
+
+//Writes the recorded spans of all threads to the specified file as Chrome trace event JSON
+bool tracing_write(const string& path);
+
+//Records the time between its construction and destruction (used by the PROFILE_ZONE() macros)
+class ProfileScope
+{
+	public:
+		ProfileScope(int zone, const char* detail = NULL)
+		{
+			this->zone = zone;
+			this->detail = detail;
+			this->startTime = nanotime();
+		}
+		
+		~ProfileScope() {
+			profiling_record(this->zone, this->startTime, nanotime() - this->startTime, this->detail);
+		}
+	
+	private:
+		ProfileScope(const ProfileScope& other);
+		ProfileScope& operator=(const ProfileScope& other);
+		
+		int zone;
+		const char* detail;
+		int64_t startTime;
+};
+
+//The zone name is only registered the first time each PROFILE_ZONE() is reached.
+//PROFILE_ZONE_DETAIL() attaches a string to the zone's spans, which must remain valid until the end of the scope.
+#define PROFILE_ZONE_CONCAT_(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT_(a, b)
+#ifdef PROFILING
+	#define PROFILE_ZONE_DETAIL(name, detail) \
+		static const int PROFILE_ZONE_CONCAT(_profileZone, __LINE__) = profiling_register_zone(name); \
+		ProfileScope PROFILE_ZONE_CONCAT(_profileScope, __LINE__)(PROFILE_ZONE_CONCAT(_profileZone, __LINE__), detail)
+	#define PROFILE_ZONE(name) PROFILE_ZONE_DETAIL(name, NULL)
+#else
+	#define PROFILE_ZONE_DETAIL(name, detail)
+	#define PROFILE_ZONE(name)
+#endif
+
+#endif
@@ -27,6 +27,9 @@
 //  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
 */
 #include "random.h"
+#include <algorithm>
+#include <atomic>
+#include <ctime>
 
 #ifdef _WIN32
 
@@ -61,15 +64,25 @@ bool GenerateRandomBytes(char* outputBuffer, size_t numBytes, bool useBestEntrop
 
 #else
 
-//On all other systems, just use /dev/random or /dev/urandom
+//On all other systems, use getrandom() where it is available (Linux 3.17 and newer), and /dev/random or /dev/urandom otherwise
 
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <pthread.h>
 
-bool GenerateRandomBytes(char* outputBuffer, size_t numBytes, bool useBestEntropy)
+#ifdef __linux__
+	#include <sys/syscall.h>
+	
+	#ifndef GRND_RANDOM
+		#define GRND_RANDOM 0x0002
+	#endif
+#endif
+
+//Reads the specified number of bytes from /dev/random or /dev/urandom
+static bool read_random_device(char* outputBuffer, size_t numBytes, bool useBestEntropy)
 {
 	//Determine whether we are using /dev/random or /dev/urandom
 	const char* fileToUse = (useBestEntropy) ? "/dev/random" : "/dev/urandom";
@@ -109,4 +122,479 @@ bool GenerateRandomBytes(char* outputBuffer, size_t numBytes, bool useBestEntrop
 	return true;
 }
 
+bool GenerateRandomBytes(char* outputBuffer, size_t numBytes, bool useBestEntropy)
+{
+	#ifdef SYS_getrandom
+	
+	//getrandom() needs no file descriptor (so it works inside chroots without /dev), and GRND_RANDOM draws from the same pool as /dev/random
+	size_t bytesToRead = numBytes;
+	while (bytesToRead)
+	{
+		long bytesRead = syscall(SYS_getrandom, outputBuffer, bytesToRead, (useBestEntropy) ? GRND_RANDOM : 0);
+		
+		//If the kernel predates getrandom(), fall back to the device files
+		if (bytesRead == -1 && errno == ENOSYS) {
+			return read_random_device(outputBuffer, bytesToRead, useBestEntropy);
+		}
+		else if (bytesRead == -1 && errno == EINTR) {
+			continue;
+		}
+		else if (bytesRead <= 0) {
+			return false;
+		}
+		
+		outputBuffer += bytesRead;
+		bytesToRead  -= bytesRead;
+	}
+	
+	return true;
+	
+	#else
+	return read_random_device(outputBuffer, numBytes, useBestEntropy);
+	#endif
+}
+
+//Incremented in the child process after each fork(), so that generators can detect that their state has been duplicated
+static std::atomic<unsigned int> forkGeneration(0);
+
+static void increment_fork_generation() {
+	forkGeneration++;
+}
+
 #endif
+
+//Retrieves the current fork generation (registering the fork handler on the first call)
+static unsigned int current_fork_generation()
+{
+	#ifdef _WIN32
+	return 0;
+	#else
+	static bool registered = (pthread_atfork(NULL, NULL, increment_fork_generation) == 0);
+	(void)registered;
+	return forkGeneration.load(std::memory_order_relaxed);
+	#endif
+}
+
+RandomDataGenerator::RandomDataGenerator()
+{
+	//Fall back to the current time and address of the generator if no entropy is available, so that we never produce a fixed sequence
+	uint64_t seed = 0;
+	if (!GenerateRandomBytes((char*)&seed, sizeof(seed))) {
+		seed = (uint64_t)time(NULL) ^ (uint64_t)(uintptr_t)this;
+	}
+	
+	this->initialSeed = seed;
+	this->state       = seed;
+}
+
+RandomDataGenerator::RandomDataGenerator(uint64_t seed)
+{
+	this->initialSeed = seed;
+	this->state       = seed;
+}
+
+//Fills a buffer with 64-bit values using the specified generator, eight bytes at a time (memcpy() compiles to a single unaligned store)
+template <typename Generator>
+static void fill_from_generator(Generator& generator, char* outputBuffer, size_t numBytes)
+{
+	while (numBytes >= sizeof(uint64_t))
+	{
+		uint64_t value = generator.next();
+		memcpy(outputBuffer, &value, sizeof(value));
+		outputBuffer += sizeof(value);
+		numBytes     -= sizeof(value);
+	}
+	
+	//Generate any remaining bytes
+	if (numBytes > 0)
+	{
+		uint64_t value = generator.next();
+		memcpy(outputBuffer, &value, numBytes);
+	}
+}
+
+void RandomDataGenerator::fill(char* outputBuffer, size_t numBytes) {
+	fill_from_generator(*this, outputBuffer, numBytes);
+}
+
+//The number of independent streams used by Xoshiro256StarStar::fill() (four 64-bit lanes fill a 256-bit vector register)
+#define XOSHIRO_FILL_LANES 4
+
+//Buffers smaller than this are filled one value at a time, since interleaving the lanes only pays off for larger buffers
+#define XOSHIRO_FILL_THRESHOLD (64 * 1024)
+
+Xoshiro256StarStar::Xoshiro256StarStar()
+{
+	//Fall back to seeding from the current time and address of the generator if no entropy is available
+	if (!GenerateRandomBytes((char*)this->state, sizeof(this->state)) || (this->state[0] | this->state[1] | this->state[2] | this->state[3]) == 0)
+	{
+		RandomDataGenerator seeder((uint64_t)time(NULL) ^ (uint64_t)(uintptr_t)this);
+		for (int i = 0; i < 4; ++i) {
+			this->state[i] = seeder.next();
+		}
+	}
+}
+
+Xoshiro256StarStar::Xoshiro256StarStar(uint64_t seed)
+{
+	//SplitMix64 never produces four consecutive zeroes, so the state is always valid
+	RandomDataGenerator seeder(seed);
+	for (int i = 0; i < 4; ++i) {
+		this->state[i] = seeder.next();
+	}
+}
+
+void Xoshiro256StarStar::jump()
+{
+	static const uint64_t polynomial[4] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+	this->applyJump(polynomial);
+}
+
+void Xoshiro256StarStar::longJump()
+{
+	static const uint64_t polynomial[4] = { 0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL };
+	this->applyJump(polynomial);
+}
+
+Xoshiro256StarStar Xoshiro256StarStar::split()
+{
+	Xoshiro256StarStar copy = *this;
+	this->jump();
+	return copy;
+}
+
+void Xoshiro256StarStar::fill(char* outputBuffer, size_t numBytes)
+{
+	if (numBytes < XOSHIRO_FILL_THRESHOLD)
+	{
+		fill_from_generator(*this, outputBuffer, numBytes);
+		return;
+	}
+	
+	//Seed the extra lanes through SplitMix64 from our own output rather than by jumping, since jumped states belong to the
+	//streams of generators produced by split(). Lay out the states so that each word of the state is contiguous across the lanes.
+	uint64_t s0[XOSHIRO_FILL_LANES], s1[XOSHIRO_FILL_LANES], s2[XOSHIRO_FILL_LANES], s3[XOSHIRO_FILL_LANES];
+	for (int lane = 1; lane < XOSHIRO_FILL_LANES; ++lane)
+	{
+		RandomDataGenerator seeder(this->next());
+		s0[lane] = seeder.next();
+		s1[lane] = seeder.next();
+		s2[lane] = seeder.next();
+		s3[lane] = seeder.next();
+	}
+	
+	//The first lane continues our own stream
+	s0[0] = this->state[0];
+	s1[0] = this->state[1];
+	s2[0] = this->state[2];
+	s3[0] = this->state[3];
+	
+	//Advance every lane in lockstep (each loop over the lanes contains no dependencies between them, so it can be vectorised)
+	const size_t blockSize = sizeof(uint64_t) * XOSHIRO_FILL_LANES;
+	uint64_t block[XOSHIRO_FILL_LANES];
+	while (numBytes >= blockSize)
+	{
+		for (int lane = 0; lane < XOSHIRO_FILL_LANES; ++lane)
+		{
+			uint64_t result = Xoshiro256StarStar::rotate(s1[lane] * 5, 7) * 9;
+			uint64_t t = s1[lane] << 17;
+			s2[lane] ^= s0[lane];
+			s3[lane] ^= s1[lane];
+			s1[lane] ^= s2[lane];
+			s0[lane] ^= s3[lane];
+			s2[lane] ^= t;
+			s3[lane] = Xoshiro256StarStar::rotate(s3[lane], 45);
+			block[lane] = result;
+		}
+		
+		memcpy(outputBuffer, block, blockSize);
+		outputBuffer += blockSize;
+		numBytes     -= blockSize;
+	}
+	
+	//Continue our own stream from where the first lane stopped
+	this->state[0] = s0[0];
+	this->state[1] = s1[0];
+	this->state[2] = s2[0];
+	this->state[3] = s3[0];
+	fill_from_generator(*this, outputBuffer, numBytes);
+}
+
+void Xoshiro256StarStar::applyJump(const uint64_t polynomial[4])
+{
+	uint64_t jumped[4] = {0, 0, 0, 0};
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int bit = 0; bit < 64; ++bit)
+		{
+			if (polynomial[i] & ((uint64_t)1 << bit))
+			{
+				for (int j = 0; j < 4; ++j) {
+					jumped[j] ^= this->state[j];
+				}
+			}
+			
+			this->next();
+		}
+	}
+	
+	memcpy(this->state, jumped, sizeof(jumped));
+}
+
+//The 128-bit multiplier used by PCG64
+#define PCG_MULTIPLIER_HIGH 0x2360ed051fc65da4ULL
+#define PCG_MULTIPLIER_LOW  0x4385df649fccf645ULL
+
+//Computes the low 128 bits of the product of two 128-bit values
+static void multiply_128(uint64_t aHigh, uint64_t aLow, uint64_t bHigh, uint64_t bLow, uint64_t& high, uint64_t& low)
+{
+	low = MultiplyFull64(aLow, bLow, &high);
+	high += aHigh * bLow + aLow * bHigh;
+}
+
+//Computes the sum of two 128-bit values
+static void add_128(uint64_t aHigh, uint64_t aLow, uint64_t bHigh, uint64_t bLow, uint64_t& high, uint64_t& low)
+{
+	low  = aLow + bLow;
+	high = aHigh + bHigh + ((low < aLow) ? 1 : 0);
+}
+
+Pcg64::Pcg64()
+{
+	uint64_t seed[2];
+	if (!GenerateRandomBytes((char*)seed, sizeof(seed)))
+	{
+		RandomDataGenerator seeder((uint64_t)time(NULL) ^ (uint64_t)(uintptr_t)this);
+		seed[0] = seeder.next();
+		seed[1] = seeder.next();
+	}
+	
+	*this = Pcg64(seed[0], seed[1]);
+}
+
+Pcg64::Pcg64(uint64_t seed, uint64_t stream)
+{
+	//Expand the seed and stream to 128 bits using SplitMix64 (the increment must be odd), then seed in the same way as the reference implementation
+	RandomDataGenerator seeder(seed ^ 0x853c49e6748fea9bULL);
+	uint64_t initialHigh = seeder.next();
+	uint64_t initialLow  = seeder.next();
+	RandomDataGenerator streamSeeder(stream ^ 0xda3e39cb94b95bdbULL);
+	this->incrementHigh = streamSeeder.next();
+	this->incrementLow  = streamSeeder.next() | 1;
+	
+	this->stateHigh = 0;
+	this->stateLow  = 0;
+	this->next();
+	add_128(this->stateHigh, this->stateLow, initialHigh, initialLow, this->stateHigh, this->stateLow);
+	this->next();
+}
+
+uint64_t Pcg64::next()
+{
+	//Advance the LCG and apply the XSL-RR output function to the new state
+	multiply_128(this->stateHigh, this->stateLow, PCG_MULTIPLIER_HIGH, PCG_MULTIPLIER_LOW, this->stateHigh, this->stateLow);
+	add_128(this->stateHigh, this->stateLow, this->incrementHigh, this->incrementLow, this->stateHigh, this->stateLow);
+	uint64_t value = this->stateHigh ^ this->stateLow;
+	unsigned int rotation = (unsigned int)(this->stateHigh >> 58);
+	return (value >> rotation) | (value << ((64 - rotation) & 63));
+}
+
+void Pcg64::advance(uint64_t delta)
+{
+	//Compose the LCG with itself by repeated squaring (Brown's algorithm), so that skipping ahead takes O(log delta) steps
+	uint64_t multiplierHigh = PCG_MULTIPLIER_HIGH, multiplierLow = PCG_MULTIPLIER_LOW;
+	uint64_t incrementHigh  = this->incrementHigh, incrementLow   = this->incrementLow;
+	uint64_t totalMultHigh  = 0,                   totalMultLow   = 1;
+	uint64_t totalIncHigh   = 0,                   totalIncLow    = 0;
+	while (delta > 0)
+	{
+		if (delta & 1)
+		{
+			multiply_128(totalMultHigh, totalMultLow, multiplierHigh, multiplierLow, totalMultHigh, totalMultLow);
+			multiply_128(totalIncHigh, totalIncLow, multiplierHigh, multiplierLow, totalIncHigh, totalIncLow);
+			add_128(totalIncHigh, totalIncLow, incrementHigh, incrementLow, totalIncHigh, totalIncLow);
+		}
+		
+		uint64_t sumHigh = 0, sumLow = 0;
+		add_128(multiplierHigh, multiplierLow, 0, 1, sumHigh, sumLow);
+		multiply_128(sumHigh, sumLow, incrementHigh, incrementLow, incrementHigh, incrementLow);
+		multiply_128(multiplierHigh, multiplierLow, multiplierHigh, multiplierLow, multiplierHigh, multiplierLow);
+		delta >>= 1;
+	}
+	
+	multiply_128(this->stateHigh, this->stateLow, totalMultHigh, totalMultLow, this->stateHigh, this->stateLow);
+	add_128(this->stateHigh, this->stateLow, totalIncHigh, totalIncLow, this->stateHigh, this->stateLow);
+}
+
+Pcg64 Pcg64::split()
+{
+	uint64_t seed   = this->next();
+	uint64_t stream = this->next();
+	return Pcg64(seed, stream);
+}
+
+void Pcg64::fill(char* outputBuffer, size_t numBytes) {
+	fill_from_generator(*this, outputBuffer, numBytes);
+}
+
+//The number of bytes of output after which an automatically-seeded ChaCha20Generator is reseeded from the kernel
+#define CHACHA_RESEED_INTERVAL (1024 * 1024)
+
+#define CHACHA_ROTATE(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define CHACHA_QUARTER_ROUND(a, b, c, d) \
+	a += b; d ^= a; d = CHACHA_ROTATE(d, 16); \
+	c += d; b ^= c; b = CHACHA_ROTATE(b, 12); \
+	a += b; d ^= a; d = CHACHA_ROTATE(d,  8); \
+	c += d; b ^= c; b = CHACHA_ROTATE(b,  7);
+
+ChaCha20Generator::ChaCha20Generator()
+{
+	this->autoReseed = true;
+	this->bytesUntilReseed = 0;
+	this->available = 0;
+	this->reseed();
+}
+
+ChaCha20Generator::ChaCha20Generator(const unsigned char key[32], uint64_t nonce)
+{
+	this->autoReseed = false;
+	this->bytesUntilReseed = 0;
+	this->available = 0;
+	this->setKey(key, nonce);
+}
+
+ChaCha20Generator::~ChaCha20Generator()
+{
+	//Wipe the key and any unused output, using a volatile pointer so that the compiler cannot omit the writes
+	volatile unsigned char* state = (volatile unsigned char*)this->state;
+	for (size_t i = 0; i < sizeof(this->state); ++i) {
+		state[i] = 0;
+	}
+	
+	volatile unsigned char* buffer = this->buffer;
+	for (size_t i = 0; i < sizeof(this->buffer); ++i) {
+		buffer[i] = 0;
+	}
+}
+
+bool ChaCha20Generator::fill(char* outputBuffer, size_t numBytes)
+{
+	//Reseed once enough output has been generated, or if the state was duplicated by fork()
+	if (this->autoReseed)
+	{
+		if ((numBytes > this->bytesUntilReseed || this->forkGeneration != current_fork_generation()) && !this->reseed()) {
+			return false;
+		}
+		
+		this->bytesUntilReseed -= std::min((uint64_t)numBytes, this->bytesUntilReseed);
+	}
+	
+	//Serve as much as we can from the buffer, erasing each byte once it has been used
+	size_t fromBuffer = std::min(numBytes, this->available);
+	unsigned char* bufferStart = this->buffer + sizeof(this->buffer) - this->available;
+	memcpy(outputBuffer, bufferStart, fromBuffer);
+	memset(bufferStart, 0, fromBuffer);
+	this->available -= fromBuffer;
+	outputBuffer    += fromBuffer;
+	numBytes        -= fromBuffer;
+	
+	//Generate whole blocks directly into the output
+	while (numBytes >= 64)
+	{
+		this->generateBlock((unsigned char*)outputBuffer);
+		outputBuffer += 64;
+		numBytes     -= 64;
+	}
+	
+	//Refill the buffer to serve any remaining bytes
+	if (numBytes > 0)
+	{
+		for (size_t offset = 0; offset < sizeof(this->buffer); offset += 64) {
+			this->generateBlock(this->buffer + offset);
+		}
+		
+		this->available = sizeof(this->buffer);
+		return this->fill(outputBuffer, numBytes);
+	}
+	
+	return true;
+}
+
+bool ChaCha20Generator::reseed()
+{
+	unsigned char seed[40];
+	if (!GenerateRandomBytes((char*)seed, sizeof(seed)))
+	{
+		this->bytesUntilReseed = 0;
+		return false;
+	}
+	
+	uint64_t nonce = 0;
+	memcpy(&nonce, seed + 32, sizeof(nonce));
+	this->setKey(seed, nonce);
+	memset(seed, 0, sizeof(seed));
+	
+	//Discard any buffered output from the previous key
+	memset(this->buffer, 0, sizeof(this->buffer));
+	this->available = 0;
+	this->bytesUntilReseed = CHACHA_RESEED_INTERVAL;
+	this->forkGeneration = current_fork_generation();
+	return true;
+}
+
+void ChaCha20Generator::setKey(const unsigned char key[32], uint64_t nonce)
+{
+	//The constant "expand 32-byte k", followed by the key, a 64-bit block counter and a 64-bit nonce (all little-endian)
+	this->state[0] = 0x61707865;
+	this->state[1] = 0x3320646e;
+	this->state[2] = 0x79622d32;
+	this->state[3] = 0x6b206574;
+	for (int i = 0; i < 8; ++i) {
+		this->state[4 + i] = (uint32_t)key[i*4] | ((uint32_t)key[i*4 + 1] << 8) | ((uint32_t)key[i*4 + 2] << 16) | ((uint32_t)key[i*4 + 3] << 24);
+	}
+	
+	this->state[12] = 0;
+	this->state[13] = 0;
+	this->state[14] = (uint32_t)nonce;
+	this->state[15] = (uint32_t)(nonce >> 32);
+	this->forkGeneration = current_fork_generation();
+}
+
+void ChaCha20Generator::generateBlock(unsigned char* output)
+{
+	uint32_t x[16];
+	memcpy(x, this->state, sizeof(x));
+	
+	//20 rounds, alternating between columns and diagonals
+	for (int i = 0; i < 10; ++i)
+	{
+		CHACHA_QUARTER_ROUND(x[0], x[4], x[8],  x[12])
+		CHACHA_QUARTER_ROUND(x[1], x[5], x[9],  x[13])
+		CHACHA_QUARTER_ROUND(x[2], x[6], x[10], x[14])
+		CHACHA_QUARTER_ROUND(x[3], x[7], x[11], x[15])
+		CHACHA_QUARTER_ROUND(x[0], x[5], x[10], x[15])
+		CHACHA_QUARTER_ROUND(x[1], x[6], x[11], x[12])
+		CHACHA_QUARTER_ROUND(x[2], x[7], x[8],  x[13])
+		CHACHA_QUARTER_ROUND(x[3], x[4], x[9],  x[14])
+	}
+	
+	for (int i = 0; i < 16; ++i)
+	{
+		uint32_t value = x[i] + this->state[i];
+		output[i*4]     = (unsigned char)value;
+		output[i*4 + 1] = (unsigned char)(value >> 8);
+		output[i*4 + 2] = (unsigned char)(value >> 16);
+		output[i*4 + 3] = (unsigned char)(value >> 24);
+	}
+	
+	//Increment the 64-bit block counter
+	if (++this->state[12] == 0) {
+		this->state[13]++;
+	}
+}
+
+bool GenerateRandomBytesBuffered(char* outputBuffer, size_t numBytes)
+{
+	static thread_local ChaCha20Generator generator;
+	return generator.fill(outputBuffer, numBytes);
+}
@@ -31,10 +31,214 @@
 
 //For size_t declaration
 #include <cstring>
+#include <stdint.h>
 
 //Generates a sequence of random bytes.
 //Under Unix-based systems, the useBestEntropy argument switches between /dev/random (true) and /dev/urandom (false)
+//(under Linux, getrandom() is used with or without GRND_RANDOM, so that no file descriptor is needed)
 //Under Windows, the useBestEntropy argument is ignored.
 bool GenerateRandomBytes(char* outputBuffer, size_t numBytes, bool useBestEntropy = false);
 
+//Generates a sequence of cryptographically-secure random bytes using a ChaCha20Generator for the calling thread.
+//Small requests are served from a buffer, so system calls are only needed when the generator is reseeded.
+bool GenerateRandomBytesBuffered(char* outputBuffer, size_t numBytes);
+
+//Cryptographically-secure generator that produces the ChaCha20 keystream, for frequent small requests (such as nonces and IDs).
+//Generators created without a key are seeded using GenerateRandomBytes(), and are reseeded after every megabyte of output and
+//in child processes after fork() (so that a parent and child never produce the same output).
+class ChaCha20Generator
+{
+	public:
+		//Creates a generator seeded from the kernel
+		ChaCha20Generator();
+		
+		//Creates a generator with the specified 256-bit key and 64-bit nonce, which is never reseeded (for reproducible output)
+		ChaCha20Generator(const unsigned char key[32], uint64_t nonce = 0);
+		
+		//Wipes the state of the generator
+		~ChaCha20Generator();
+		
+		//Fills the supplied buffer with random bytes, returning false if the generator needed to be reseeded and reseeding failed
+		bool fill(char* outputBuffer, size_t numBytes);
+	
+	private:
+		ChaCha20Generator(const ChaCha20Generator& other);
+		ChaCha20Generator& operator=(const ChaCha20Generator& other);
+		
+		bool reseed();
+		void setKey(const unsigned char key[32], uint64_t nonce);
+		void generateBlock(unsigned char* output);
+		
+		uint32_t state[16];
+		unsigned char buffer[256];
+		size_t available;
+		bool autoReseed;
+		uint64_t bytesUntilReseed;
+		unsigned int forkGeneration;
+};
+
+//Fast (non-cryptographic) generator for bulk pseudorandom data, based on SplitMix64.
+//The same seed always produces the same sequence of bytes, which allows test fixtures to be reproduced.
+class RandomDataGenerator
+{
+	public:
+		//Creates a generator with a seed obtained from GenerateRandomBytes()
+		RandomDataGenerator();
+		
+		//Creates a generator with the specified seed
+		RandomDataGenerator(uint64_t seed);
+		
+		//Retrieves the seed that the generator was created with
+		uint64_t seed() const { return this->initialSeed; }
+		
+		//Generates the next 64 bits of output
+		uint64_t next()
+		{
+			uint64_t z = (this->state += 0x9E3779B97F4A7C15ULL);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			return z ^ (z >> 31);
+		}
+		
+		//Fills the supplied buffer with pseudorandom bytes
+		void fill(char* outputBuffer, size_t numBytes);
+	
+	private:
+		uint64_t initialSeed;
+		uint64_t state;
+};
+
+//Fast (non-cryptographic) xoshiro256** generator, for simulation and sampling.
+//Each jump() advances the generator by 2^128 outputs, so split() can divide a single seed into non-overlapping per-thread streams.
+class Xoshiro256StarStar
+{
+	public:
+		//Creates a generator with a seed obtained from GenerateRandomBytes()
+		Xoshiro256StarStar();
+		
+		//Creates a generator whose 256-bit state is expanded from the specified seed using SplitMix64
+		Xoshiro256StarStar(uint64_t seed);
+		
+		//Generates the next 64 bits of output
+		uint64_t next()
+		{
+			uint64_t result = Xoshiro256StarStar::rotate(this->state[1] * 5, 7) * 9;
+			uint64_t t = this->state[1] << 17;
+			this->state[2] ^= this->state[0];
+			this->state[3] ^= this->state[1];
+			this->state[1] ^= this->state[2];
+			this->state[0] ^= this->state[3];
+			this->state[2] ^= t;
+			this->state[3] = Xoshiro256StarStar::rotate(this->state[3], 45);
+			return result;
+		}
+		
+		//Advances the generator by 2^128 outputs
+		void jump();
+		
+		//Advances the generator by 2^192 outputs
+		void longJump();
+		
+		//Returns a copy of the generator and then jumps, so that the returned generator and this one produce non-overlapping streams
+		Xoshiro256StarStar split();
+		
+		//Fills the supplied buffer with pseudorandom bytes.
+		//Large buffers are filled by several lanes in parallel, which the compiler can vectorise, so the output differs from
+		//repeated calls to next() (but is still determined entirely by the seed). The first lane continues this generator's
+		//own stream, while the others are seeded from its output using SplitMix64, so the fill output is not part of the
+		//jump() / longJump() lattice and never reproduces the streams of generators produced by split().
+		void fill(char* outputBuffer, size_t numBytes);
+	
+	private:
+		static uint64_t rotate(uint64_t value, int bits) {
+			return (value << bits) | (value >> (64 - bits));
+		}
+		
+		void applyJump(const uint64_t polynomial[4]);
+		
+		uint64_t state[4];
+};
+
+//Fast (non-cryptographic) PCG64 generator (a 128-bit LCG with the XSL-RR output function), for simulation and sampling.
+//Generators with different stream numbers produce independent sequences, and advance() skips ahead in logarithmic time.
+class Pcg64
+{
+	public:
+		//Creates a generator with a seed and stream obtained from GenerateRandomBytes()
+		Pcg64();
+		
+		//Creates a generator with the specified seed and stream
+		Pcg64(uint64_t seed, uint64_t stream = 0);
+		
+		//Generates the next 64 bits of output
+		uint64_t next();
+		
+		//Advances the generator by the specified number of outputs
+		void advance(uint64_t delta);
+		
+		//Returns a new generator on a different stream, seeded from the output of this one
+		Pcg64 split();
+		
+		//Fills the supplied buffer with pseudorandom bytes
+		void fill(char* outputBuffer, size_t numBytes);
+	
+	private:
+		uint64_t stateHigh;
+		uint64_t stateLow;
+		uint64_t incrementHigh;
+		uint64_t incrementLow;
+};
+
+//Computes the full 128-bit product of two 64-bit values
+inline uint64_t MultiplyFull64(uint64_t a, uint64_t b, uint64_t* high)
+{
+	#ifdef __SIZEOF_INT128__
+	unsigned __int128 product = (unsigned __int128)a * b;
+	*high = (uint64_t)(product >> 64);
+	return (uint64_t)product;
+	#else
+	uint64_t aLow = (uint32_t)a, aHigh = a >> 32;
+	uint64_t bLow = (uint32_t)b, bHigh = b >> 32;
+	uint64_t lowLow  = aLow * bLow;
+	uint64_t highLow = aHigh * bLow;
+	uint64_t lowHigh = aLow * bHigh;
+	uint64_t cross   = (lowLow >> 32) + (uint32_t)highLow + lowHigh;
+	*high = aHigh * bHigh + (highLow >> 32) + (cross >> 32);
+	return (cross << 32) | (uint32_t)lowLow;
+	#endif
+}
+
+//Generates an unbiased integer in the range [0, bound) using any of the generators above (Lemire's multiply-and-reject method,
+//which only needs a division in the rare case that a sample might be rejected)
+template <typename Generator>
+uint64_t RandomBoundedInteger(Generator& generator, uint64_t bound)
+{
+	uint64_t high = 0;
+	uint64_t low = MultiplyFull64(generator.next(), bound, &high);
+	if (low < bound)
+	{
+		uint64_t threshold = (0 - bound) % bound;
+		while (low < threshold) {
+			low = MultiplyFull64(generator.next(), bound, &high);
+		}
+	}
+	
+	return high;
+}
+
+//Generates an unbiased integer in the range [minimum, maximum] using any of the generators above
+template <typename Generator>
+int64_t RandomIntegerInRange(Generator& generator, int64_t minimum, int64_t maximum)
+{
+	uint64_t span = (uint64_t)maximum - (uint64_t)minimum + 1;
+	uint64_t offset = (span == 0) ? generator.next() : RandomBoundedInteger(generator, span);
+	return (int64_t)((uint64_t)minimum + offset);
+}
+
+//Generates a uniformly-distributed double in the range [0, 1) using any of the generators above (all 53 bits of the mantissa are random)
+template <typename Generator>
+double RandomUniformDouble(Generator& generator) {
+	return (double)(generator.next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
 #endif
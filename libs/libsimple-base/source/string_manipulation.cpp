@@ -27,6 +27,19 @@
 //  along with libsimple-base. If not, see <http://www.gnu.org/licenses/>.
 */
 #include "string_manipulation.h"
+#include "FilePath.h"
+#include "StringBuilder.h"
+
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef __SSE2__
+	#include <emmintrin.h>
+#endif
 
 //PHP String Functions, behave the same as their PHP counterparts
 
@@ -85,25 +98,26 @@ string dirname (const string& path)
 
 string implode(const string& glue, const vector<string>& pieces)
 {
-	//Create a string to hold the result
-	string result = "";
-	
 	//Check that the vector is not empty
-	if (pieces.size() > 0)
-	{
-		//Loop through all but the last of the array elements
-		for (size_t i = 0; i < pieces.size()-1; ++i)
-		{
-			//Concatenate the element, with the delimiter
-			result += pieces[i] + glue;
-		}
-		
-		//Concatenate the last element
-		result += pieces[pieces.size()-1];
+	if (pieces.empty()) {
+		return string();
+	}
+	
+	//Compute the exact length of the result so that only a single allocation is performed
+	size_t length = glue.length() * (pieces.size() - 1);
+	for (size_t i = 0; i < pieces.size(); ++i) {
+		length += pieces[i].length();
+	}
+	
+	//Concatenate the first element, and then each of the remaining elements preceded by the glue
+	StringBuilder result(length);
+	result.append(pieces[0]);
+	for (size_t i = 1; i < pieces.size(); ++i) {
+		result.append(glue).append(pieces[i]);
 	}
 	
 	//Return the result
-	return result;
+	return result.release();
 }
 
 //Written by me, but based loosely on the str_replace function above
@@ -155,33 +169,51 @@ vector<string> explode(const string& delim, const string& s, size_t limit)
 
 string urldecode (string uri)
 {
-	//Traverse the string, looking for %
-	size_t lastPos = 0;
-	size_t foundPos = string::npos;
-	while ((foundPos = uri.find('%', lastPos)) != string::npos)
+	//Decode in a single pass, leaving invalid or truncated escape sequences intact
+	string decoded;
+	urldecode(uri, decoded, false);
+	return decoded;
+}
+
+bool urldecode (const string& uri, string& decoded, bool validateUtf8)
+{
+	//The decoded string can never be longer than the encoded one
+	decoded.clear();
+	decoded.reserve(uri.length());
+	
+	//Traverse the string, copying each run of characters up to the next % in bulk (memchr is vectorised)
+	const char* pos = uri.data();
+	const char* end = pos + uri.length();
+	while (pos < end)
 	{
-		//Check that there are two characters after the %
-		if (uri.length() > foundPos + 2)
+		const char* percent = (const char*)memchr(pos, '%', end - pos);
+		if (percent == NULL)
 		{
-			//Retrieve the two characters after the %
-			string entity = uri.substr(foundPos + 1, 2);
-			
-			//Convert the hex to decimal
-			long int decimal = hex_to_dec(entity);
-			
-			//Truncate to one byte and cast as a character
-			char decoded = decimal;
-			
-			//Replace the encoded form with the decoded character
-			uri.replace(foundPos, 3, string(1, decoded));
+			decoded.append(pos, end - pos);
+			break;
 		}
 		
-		//Prevent a match ocurring next time if the decoded character was %
-		lastPos = foundPos + 1;
+		decoded.append(pos, percent - pos);
+		
+		//Check that there are two valid hex digits after the %
+		int high = (end - percent > 2) ? hex_digit_value(percent[1]) : -1;
+		int low  = (high != -1)        ? hex_digit_value(percent[2]) : -1;
+		if (low != -1)
+		{
+			//Append the decoded character
+			decoded.push_back((char)((high << 4) | low));
+			pos = percent + 3;
+		}
+		else
+		{
+			//Not an escape sequence, keep the % as-is
+			decoded.push_back('%');
+			pos = percent + 1;
+		}
 	}
 	
-	//Return the decoded string
-	return uri;
+	//Validate the decoded string if requested
+	return (!validateUtf8 || is_valid_utf8(decoded));
 }
 
 string strtoupper (const string& s)
@@ -314,27 +346,8 @@ bool ends_with (const string& end, const string& s)
 
 string replace_extension (const string& s, string newExtension)
 {
-	//See where the last occurence of a period, and also a slash, are
-	size_t dotPos   = s.find_last_of(".");
-	size_t slashPos = s.find_last_of("\\/");
-	
-	//Check to see that a period was actually found, after all slashes
-	if (dotPos != string::npos && (slashPos == string::npos || dotPos > slashPos))
-	{
-		//Create a copy of the original string to work on
-		string newpath = s;
-		
-		//Replace all of the characters after the last period with the new extension
-		newpath.replace(dotPos + 1, newpath.length() - (dotPos + 1), newExtension);
-		
-		//Return the new file path
-		return newpath;
-	}
-	else
-	{
-		//No period was found, so simply append the new file extension
-		return s + "." + newExtension;
-	}
+	//FilePath locates the last period and slash for us, and only treats the period as an extension after all slashes
+	return FilePath(s).replaceExtension(newExtension).str();
 }
 
 string replace_first (const string& search, const string& replace, const string& haystack)
@@ -432,65 +445,220 @@ long int hex_to_dec(const string& hex)
 	return strtol(hex.c_str(), NULL, 16);
 }
 
-//Filesize suffixes
-#define KB   * (1000)
-#define MB   * (1000 * 1000)
-#define GB   * (1000 * 1000 * 1000)
+int hex_digit_value(char c)
+{
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
 
-#define KiB  * (1024)
-#define MiB  * (1024 * 1024)
-#define GiB  * (1024 * 1024 * 1024)
+//Determines the length of the run of RFC 3986 unreserved characters (A-Z a-z 0-9 - _ . ~) at the start of the supplied data
+static size_t unreserved_run_length(const char* data, size_t length)
+{
+	size_t i = 0;
+	
+	#ifdef __SSE2__
+	
+	//Classify 16 characters at a time. Bytes >= 0x80 are negative as signed chars, so they fall outside every range.
+	const __m128i lowerA = _mm_set1_epi8('a' - 1);
+	const __m128i lowerZ = _mm_set1_epi8('z' + 1);
+	const __m128i digit0 = _mm_set1_epi8('0' - 1);
+	const __m128i digit9 = _mm_set1_epi8('9' + 1);
+	const __m128i caseBit = _mm_set1_epi8(0x20);
+	const __m128i hyphen = _mm_set1_epi8('-');
+	const __m128i under  = _mm_set1_epi8('_');
+	const __m128i period = _mm_set1_epi8('.');
+	const __m128i tilde  = _mm_set1_epi8('~');
+	for (; i + 16 <= length; i += 16)
+	{
+		__m128i chars  = _mm_loadu_si128((const __m128i*)(data + i));
+		
+		//Folding the case bit maps A-Z onto a-z without mapping any other characters onto a-z
+		__m128i folded = _mm_or_si128(chars, caseBit);
+		__m128i alpha  = _mm_and_si128(_mm_cmpgt_epi8(folded, lowerA), _mm_cmpgt_epi8(lowerZ, folded));
+		__m128i digits = _mm_and_si128(_mm_cmpgt_epi8(chars, digit0), _mm_cmpgt_epi8(digit9, chars));
+		__m128i marks  = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars, hyphen), _mm_cmpeq_epi8(chars, under)), _mm_or_si128(_mm_cmpeq_epi8(chars, period), _mm_cmpeq_epi8(chars, tilde)));
+		
+		//If any character in the block needs escaping, locate the first one
+		int mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digits), marks));
+		if (mask != 0xffff) {
+			return i + __builtin_ctz(~mask);
+		}
+	}
+	
+	#endif
+	
+	//Process any remaining characters one at a time
+	for (; i < length; ++i)
+	{
+		unsigned char c = (unsigned char)data[i];
+		if (!isalnum(c) && c != '-' && c != '_' && c != '.' && c != '~') {
+			break;
+		}
+	}
+	
+	return i;
+}
 
-int intFromSuffix(const string& s)
+string urlencode(const string& s)
 {
-	//Create an int to hold the result
-	int result = toInt(s);
+	//Reserve enough space for the common case of mostly unreserved characters
+	StringBuilder encoded(s.length() + (s.length() / 4));
 	
-	//Check for suffixes
-	if (s.length() > 2)
+	const char* data = s.data();
+	size_t length = s.length();
+	size_t pos = 0;
+	while (pos < length)
 	{
-		//This will hold the number itself where applicable
-		int num = 0;
+		//Copy the run of unreserved characters in bulk
+		size_t run = unreserved_run_length(data + pos, length - pos);
+		encoded.append(data + pos, run);
+		pos += run;
 		
-		//If the length is long enough, check for 3-letter suffixes (KiB, MiB, GiB)
-		if (s.length() > 3)
+		//Escape the character that ended the run
+		if (pos < length)
 		{
-			//Extract the last three characters
-			string lastThree = strtolower(s.substr(s.length() - 3));
-			
-			//Extract the number itself
-			num = toInt(s.substr(0, s.length() - 3));
-			
-			//Check for the supported suffixes
-			if      (lastThree == "kib")
-				result = num KiB;
-			else if (lastThree == "mib")
-				result = num MiB;
-			else if (lastThree == "gib")
-				result = num GiB;
+			unsigned char c = (unsigned char)data[pos++];
+			char escape[3] = { '%', "0123456789ABCDEF"[c >> 4], "0123456789ABCDEF"[c & 0x0f] };
+			encoded.append(escape, 3);
 		}
+	}
+	
+	return encoded.release();
+}
+
+bool is_valid_utf8(const string& s) {
+	return is_valid_utf8(s.data(), s.length());
+}
+
+bool is_valid_utf8(const char* data, size_t length)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	size_t i = 0;
+	while (i < length)
+	{
+		#ifdef __SSE2__
 		
-		//Check for the 2-letter suffixes (KB, MB, GB)
+		//Skip over blocks of 16 ASCII characters (none of which have their high bit set)
+		while (i + 16 <= length && _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(bytes + i))) == 0) {
+			i += 16;
+		}
 		
-		//Extract the last two characters
-		string lastTwo = strtolower(s.substr(s.length() - 2));
+		if (i >= length) {
+			break;
+		}
 		
-		//Extract the number itself
-		num = toInt(s.substr(0, s.length() - 2));
+		#endif
 		
-		//Check for the supported suffixes
-		if      (lastTwo == "kb")
-			result = num KB;
-		else if (lastTwo == "mb")
-			result = num MB;
-		else if (lastTwo == "gb")
-			result = num GB;
+		unsigned char lead = bytes[i];
+		if (lead < 0x80)
+		{
+			++i;
+			continue;
+		}
+		
+		//Determine the sequence length and the valid range for the second byte (which rules out overlong forms, surrogates and values above U+10FFFF)
+		size_t sequenceLength = 0;
+		unsigned char minSecond = 0x80;
+		unsigned char maxSecond = 0xbf;
+		if      (lead >= 0xc2 && lead <= 0xdf) { sequenceLength = 2; }
+		else if (lead == 0xe0)                 { sequenceLength = 3; minSecond = 0xa0; }
+		else if (lead >= 0xe1 && lead <= 0xec) { sequenceLength = 3; }
+		else if (lead == 0xed)                 { sequenceLength = 3; maxSecond = 0x9f; }
+		else if (lead >= 0xee && lead <= 0xef) { sequenceLength = 3; }
+		else if (lead == 0xf0)                 { sequenceLength = 4; minSecond = 0x90; }
+		else if (lead >= 0xf1 && lead <= 0xf3) { sequenceLength = 4; }
+		else if (lead == 0xf4)                 { sequenceLength = 4; maxSecond = 0x8f; }
+		else {
+			return false;
+		}
+		
+		//Validate the continuation bytes
+		if (length - i < sequenceLength || bytes[i + 1] < minSecond || bytes[i + 1] > maxSecond) {
+			return false;
+		}
+		
+		for (size_t j = 2; j < sequenceLength; ++j)
+		{
+			if ((bytes[i + j] & 0xc0) != 0x80) {
+				return false;
+			}
+		}
+		
+		i += sequenceLength;
 	}
-	else
-		result = toInt(s);
 	
-	//Return the result
-	return result;
+	return true;
+}
+
+int intFromSuffix(const string& s)
+{
+	//Sizes that are invalid or do not fit in an int are treated in the same way as strings that are not numbers
+	uint64_t value = 0;
+	if (!parse_size(s, value) || value > (uint64_t)INT_MAX) {
+		return 0;
+	}
+	
+	return (int)value;
+}
+
+bool parse_size(const string& s, uint64_t& value)
+{
+	//Parse the number, rejecting signs and whitespace (which strtoull() would otherwise accept)
+	if (s.empty() || !isdigit((unsigned char)s[0])) {
+		return false;
+	}
+	
+	errno = 0;
+	char* end = NULL;
+	unsigned long long number = strtoull(s.c_str(), &end, 10);
+	if (errno == ERANGE) {
+		return false;
+	}
+	
+	//Determine the multiplier for the suffix (single letters and the IEC suffixes are powers of 1024, while KB, MB, etc. are powers of 1000)
+	string suffix = strtoupper(string(end));
+	static const char* prefixes = "KMGT";
+	uint64_t multiplier = 1;
+	if (!suffix.empty())
+	{
+		const char* prefix = (suffix.length() <= 3) ? strchr(prefixes, suffix[0]) : NULL;
+		if (prefix == NULL) {
+			return false;
+		}
+		
+		int power = (int)(prefix - prefixes) + 1;
+		string unit = suffix.substr(1);
+		uint64_t base = 0;
+		if      (unit == "" || unit == "IB") { base = 1024; }
+		else if (unit == "B")                { base = 1000; }
+		else {
+			return false;
+		}
+		
+		for (int i = 0; i < power; ++i) {
+			multiplier *= base;
+		}
+	}
+	
+	//Check that the scaled value still fits
+	if (number > UINT64_MAX / multiplier) {
+		return false;
+	}
+	
+	value = (uint64_t)number * multiplier;
+	return true;
+}
+
+uint64_t parse_size(const string& s)
+{
+	uint64_t value = 0;
+	if (!parse_size(s, value)) {
+		throw std::runtime_error("invalid size \"" + s + "\"");
+	}
+	
+	return value;
 }
 
 //Breaks a command string into an argv-style structure
@@ -574,3 +742,85 @@ vector<string> argv_from_string(string command)
 	
 	return result;
 }
+
+bool wildcard_match(const string& pattern, const string& s)
+{
+	//When a mismatch occurs, we backtrack to the most recent * and let it consume one more character
+	size_t p = 0;
+	size_t i = 0;
+	size_t starPattern = string::npos;
+	size_t starString  = 0;
+	
+	while (i < s.length())
+	{
+		if (p < pattern.length() && pattern[p] == '*')
+		{
+			starPattern = p++;
+			starString  = i;
+			continue;
+		}
+		
+		if (p < pattern.length() && pattern[p] == '[')
+		{
+			//Parse the set, which may be negated with ! or ^ and may contain ranges such as a-z
+			size_t pos = p + 1;
+			bool negated = (pos < pattern.length() && (pattern[pos] == '!' || pattern[pos] == '^'));
+			if (negated) {
+				++pos;
+			}
+			
+			bool matched = false;
+			size_t setStart = pos;
+			while (pos < pattern.length() && (pattern[pos] != ']' || pos == setStart))
+			{
+				if (pos + 2 < pattern.length() && pattern[pos + 1] == '-' && pattern[pos + 2] != ']')
+				{
+					matched = matched || (s[i] >= pattern[pos] && s[i] <= pattern[pos + 2]);
+					pos += 3;
+				}
+				else
+				{
+					matched = matched || (s[i] == pattern[pos]);
+					pos++;
+				}
+			}
+			
+			//An unterminated set is treated as a literal [
+			if (pos >= pattern.length())
+			{
+				if (s[i] == '[')
+				{
+					++p;
+					++i;
+					continue;
+				}
+			}
+			else if (matched != negated)
+			{
+				p = pos + 1;
+				++i;
+				continue;
+			}
+		}
+		else if (p < pattern.length() && (pattern[p] == '?' || pattern[p] == s[i]))
+		{
+			++p;
+			++i;
+			continue;
+		}
+		
+		if (starPattern == string::npos) {
+			return false;
+		}
+		
+		p = starPattern + 1;
+		i = ++starString;
+	}
+	
+	//Any remaining pattern characters must all be *
+	while (p < pattern.length() && pattern[p] == '*') {
+		++p;
+	}
+	
+	return (p == pattern.length());
+}
@@ -34,6 +34,7 @@
 #include <algorithm>
 #include <vector>
 #include <cstddef>
+#include <stdint.h>
 using std::string;
 using std::stringstream;
 using std::vector;
@@ -49,6 +50,7 @@ string         dirname     (const string& path);
 string         implode     (const string& delim, const vector<string>& array);
 vector<string> explode     (const string& delim, const string& s, size_t limit = 0);
 string         urldecode   (string uri);
+bool           urldecode   (const string& uri, string& decoded, bool validateUtf8 = true); //Returns false if validation is requested and the decoded string is not valid UTF-8
 string         strtoupper  (const string& s);
 string         strtolower  (const string& s);
 
@@ -69,9 +71,16 @@ string          strip_quotes       (const string& s, bool recursive = false);
 string          addquotes          (const string& s);                                                      //Wraps double qoutes around a string
 string          determine_quotes   (const string& s, bool checkForExistingQuotes = false);                 //If the supplied string has spaces in it, wrap it in double quotes
 string          unix_line_endings  (const string& s);                                                      //Converts all line endings to UNIX style (\n)
-int             intFromSuffix      (const string& s);                                                      //Takes a string like "4MB" or "2MiB" and returns the computed value
+int             intFromSuffix      (const string& s);                                                      //Takes a string like "4MB" or "2MiB" and returns the computed value (using parse_size()), or zero if it is invalid or does not fit in an int
+bool            parse_size         (const string& s, uint64_t& value);                                     //Parses a size with an optional K, M, G or T suffix (powers of 1024, as are KiB, MiB, etc., while KB, MB, etc. are powers of 1000), returning false if it is invalid or too large
+uint64_t        parse_size         (const string& s);                                                      //As above, but throws a std::runtime_error if the size is invalid or too large (for command-line tools)
 long int        hex_to_dec         (const string& hex);                                                    //Converts a hex string to a decimal integer
+int             hex_digit_value    (char c);                                                               //Converts a single hex digit to its value, or returns -1 if it is not a hex digit
+string          urlencode          (const string& s);                                                      //Percent-encodes everything except RFC 3986 unreserved characters (spaces become %20, so urldecode() reverses it)
+bool            is_valid_utf8      (const string& s);                                                      //Determines whether a string is well-formed UTF-8 (rejecting overlong forms and surrogates)
+bool            is_valid_utf8      (const char* data, size_t length);
 vector<string>  argv_from_string   (string command);                                                       //Breaks a command string into an argv-style structure
+bool            wildcard_match     (const string& pattern, const string& s);                               //Matches a shell-style pattern (*, ? and [...] sets) against the entire string, with * also matching slashes
 
 //Template Functions for type juggling
 
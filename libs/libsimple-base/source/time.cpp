@@ -105,6 +105,32 @@ timeval microtime()
 	return theTime;
 }
 
+int64_t nanotime()
+{
+	#ifdef _WIN32
+	
+	//Use the performance counter, converting to nanoseconds in two parts to avoid overflow
+	static LARGE_INTEGER frequency = {};
+	if (frequency.QuadPart == 0) {
+		QueryPerformanceFrequency(&frequency);
+	}
+	
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	int64_t seconds = counter.QuadPart / frequency.QuadPart;
+	int64_t remainder = counter.QuadPart % frequency.QuadPart;
+	return (seconds * 1000000000) + ((remainder * 1000000000) / frequency.QuadPart);
+	
+	#else
+	
+	//Under Linux, CLOCK_MONOTONIC is read through the vDSO without entering the kernel
+	timespec theTime;
+	clock_gettime(CLOCK_MONOTONIC, &theTime);
+	return ((int64_t)theTime.tv_sec * 1000000000) + theTime.tv_nsec;
+	
+	#endif
+}
+
 double timeDiff(const timeval& firstTime, const timeval& secondTime)
 {
 	//Calculate the difference in seconds
@@ -35,12 +35,17 @@
 	#include <sys/time.h>
 #endif
 
+#include <stdint.h>
 #include <string>
 using std::string;
 
 //Returns a structure containing the current time in seconds and microseconds
+//(this follows the system time, which may jump backwards or forwards, so use nanotime() or a Stopwatch to measure intervals)
 timeval microtime();
 
+//Returns the current value of a monotonic clock in nanoseconds (the starting point is arbitrary, but the clock never jumps)
+int64_t nanotime();
+
 //Calculates the difference, in seconds, between two timestamps
 double timeDiff(const timeval& firstTime, const timeval& secondTime);
 
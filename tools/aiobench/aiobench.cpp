@@ -0,0 +1,213 @@
+/*
+//  Asynchronous I/O Benchmark
+//  Copyright (c) 2016, Adam Rehn
+//  
+//  ---
+//  
+//  This utility measures the throughput of random reads from a file at a
+//  range of queue depths, using each of the available asynchronous I/O
+//  backends (io_uring and the thread pool).
+//  
+//  Usage Syntax:    aiobench [OPTIONS] FILE
+//  
+//  Sizes may include a K, M or G suffix (powers of 1024).
+//  
+//  Options:
+//  
+//    --block N     The size of each read (default 4K)
+//    --total N     The amount of data read at each queue depth (default 256M)
+//    --depth N     The largest queue depth to test (default 128)
+//    --direct      Bypass the page cache by opening the file with O_DIRECT
+//  
+//  Queue depths are tested from 1 upwards, doubling each time. Every run
+//  reads the same sequence of offsets, so the first run may be slower if the
+//  file is not already cached (use --direct to avoid the effect of caching).
+//  
+//  ---
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+*/
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <functional>
+#include <vector>
+#include <string>
+#include <fcntl.h>
+#include <simple-base/base.h>
+
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+	#define O_BINARY 0
+#endif
+
+using namespace std;
+
+struct BenchmarkResult
+{
+	double   seconds;
+	uint64_t reads;
+	uint64_t bytes;
+	bool     failed;
+};
+
+//Performs random reads with the specified number of reads in flight at once
+BenchmarkResult runBenchmark(AsyncIO& io, int fd, uint64_t fileSize, unsigned int depth, size_t blockSize, uint64_t totalBytes)
+{
+	BenchmarkResult result = {0.0, 0, 0, false};
+	RandomDataGenerator generator(0);
+	uint64_t numBlocks = fileSize / blockSize;
+	uint64_t remaining = totalBytes / blockSize;
+	
+	//Each completed read issues the next read into the same buffer, keeping the queue full until all reads are issued
+	std::function<void(int)> issueRead = [&](int bufferIndex)
+	{
+		if (remaining == 0) {
+			return;
+		}
+		
+		remaining--;
+		int64_t offset = (generator.next() % numBlocks) * blockSize;
+		io.readFixed(fd, bufferIndex, blockSize, offset, [&, bufferIndex](int64_t bytesRead)
+		{
+			if (bytesRead < 0) {
+				result.failed = true;
+			}
+			else
+			{
+				result.reads++;
+				result.bytes += bytesRead;
+			}
+			
+			issueRead(bufferIndex);
+		});
+	};
+	
+	Stopwatch timer;
+	for (unsigned int i = 0; i < depth; ++i)
+	{
+		int bufferIndex = io.acquireBuffer();
+		if (bufferIndex == -1)
+		{
+			//Wait for the reads that were already issued, since their callbacks refer to this stack frame
+			remaining = 0;
+			io.drain();
+			throw std::runtime_error("failed to acquire a buffer for each read in flight");
+		}
+		
+		issueRead(bufferIndex);
+	}
+	
+	io.drain();
+	result.seconds = (double)timer.elapsed() / 1000000000.0;
+	return result;
+}
+
+int main (int argc, char* argv[])
+{
+	try
+	{
+		uint64_t blockSize  = 4096;
+		uint64_t totalBytes = 256 << 20;
+		unsigned int maxDepth = 128;
+		bool directIO = false;
+		string inputFile;
+		
+		//Parse the supplied arguments
+		for (int i = 1; i < argc; ++i)
+		{
+			string currArg = argv[i];
+			if      (currArg == "--direct")                { directIO   = true; }
+			else if (currArg == "--block" && i + 1 < argc) { blockSize  = parse_size(argv[++i]); }
+			else if (currArg == "--total" && i + 1 < argc) { totalBytes = parse_size(argv[++i]); }
+			else if (currArg == "--depth" && i + 1 < argc) { maxDepth   = (unsigned int)parse_size(argv[++i]); }
+			else {
+				inputFile = currArg;
+			}
+		}
+		
+		if (inputFile.empty())
+		{
+			clog << "Usage syntax:\naiobench [--block N] [--total N] [--depth N] [--direct] FILE" << endl;
+			return 0;
+		}
+		
+		//Open the input file
+		int flags = O_RDONLY | O_BINARY;
+		#ifdef O_DIRECT
+		if (directIO) {
+			flags |= O_DIRECT;
+		}
+		#endif
+		
+		int fd = open(inputFile.c_str(), flags);
+		if (fd == -1) {
+			throw std::runtime_error("failed to open input file \"" + inputFile + "\"");
+		}
+		
+		uint64_t fileSize = file_info(fd).size;
+		if (blockSize == 0 || fileSize < blockSize) {
+			throw std::runtime_error("the input file must be at least one block in size");
+		}
+		
+		//Determine which backends are available
+		vector<bool> backends;
+		if (AsyncIO(1).backend() == AsyncIO::IO_URING) {
+			backends.push_back(true);
+		}
+		else {
+			clog << "Note: io_uring is not available, only the thread pool will be tested" << endl;
+		}
+		
+		backends.push_back(false);
+		
+		printf("%-12s %6s %10s %12s\n", "Backend", "Depth", "MiB/s", "Reads/s");
+		for (vector<bool>::iterator allowIoUring = backends.begin(); allowIoUring != backends.end(); ++allowIoUring)
+		{
+			for (unsigned int depth = 1; depth <= maxDepth; depth *= 2)
+			{
+				AsyncIO io(depth, depth, blockSize, *allowIoUring);
+				BenchmarkResult result = runBenchmark(io, fd, fileSize, depth, blockSize, totalBytes);
+				if (result.failed) {
+					throw std::runtime_error("reading from the input file failed");
+				}
+				
+				printf(
+					"%-12s %6u %10.1f %12.0f\n",
+					(io.backend() == AsyncIO::IO_URING) ? "io_uring" : "threadpool",
+					depth,
+					((double)result.bytes / (1024.0 * 1024.0)) / result.seconds,
+					(double)result.reads / result.seconds
+				);
+			}
+		}
+		
+		close(fd);
+	}
+	catch (std::runtime_error& e)
+	{
+		clog << "Error: " << e.what() << endl;
+		return 1;
+	}
+	
+	return 0;
+}
@@ -32,27 +32,128 @@
 //  SOFTWARE.
 */
 #include <iostream>
-#include <fstream>
 #include <stdexcept>
 #include <vector>
 #include <string>
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
 #include <simple-base/base.h>
 
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+	#define O_BINARY 0
+#endif
+
+//The size of the buffer used when reading files that cannot be mapped
 #define BUFSIZE (4 * 1024 * 1024)
 
 using namespace std;
 
-//Extracts the header from a CSV file, or throws an error if one wasn't found
-string extractHeader(istream& csvFile, const string& filename)
+//Writes the supplied data to the output file, or throws an error if writing failed
+void writeData(int outfile, string_view data)
+{
+	if (!write_all(outfile, data.data(), data.length())) {
+		throw std::runtime_error("failed to write output file!");
+	}
+}
+
+//Reads from the input file, retrying if the read is interrupted by a signal. Returns the number of bytes read, or -1 on failure.
+int readData(int infile, char* buffer, unsigned int length)
 {
-	string header = "";
-	getline(csvFile, header, '\n');
+	int bytesRead = 0;
+	while ((bytesRead = (int)read(infile, buffer, length)) == -1 && errno == EINTR) {}
+	return bytesRead;
+}
+
+//Verifies the header row of an input file, or adopts it as the header row and writes it to the output file if this is the first input file
+void checkHeader(int outfile, string_view header, string& headerRow, bool& haveHeader, const string& filename)
+{
+	if (!haveHeader)
+	{
+		headerRow = string(header);
+		haveHeader = true;
+		writeData(outfile, headerRow + "\n");
+	}
+	else if (header != headerRow) {
+		throw std::runtime_error("the header for file \"" + filename + "\" does not match the header row of the first input file!");
+	}
+}
+
+//Copies the rows of a regular file to the output file, reading it through a mapping and letting the kernel copy the data where possible
+void copyMappedFile(int outfile, const string& filename, string& headerRow, bool& haveHeader)
+{
+	MappedFile csvFile(filename, MappedFile::ReadOnly, MappedFile::Sequential);
+	if (!csvFile.isOpen() || csvFile.size() == 0) {
+		throw std::runtime_error("failed to read header row from file \"" + filename + "\"!");
+	}
 	
-	if (csvFile.fail()) {
+	string_view contents = csvFile.view();
+	string_view header = contents.substr(0, contents.find('\n'));
+	checkHeader(outfile, header, headerRow, haveHeader, filename);
+	
+	size_t rowsOffset = std::min(header.length() + 1, csvFile.size());
+	string_view rows = contents.substr(rowsOffset);
+	if (copy_range(csvFile.descriptor(), rowsOffset, outfile, -1, rows.length()) != (int64_t)rows.length()) {
+		throw std::runtime_error("failed to copy the rows of file \"" + filename + "\"!");
+	}
+	
+	//If the input file didn't end with a trailing newline, append one ourselves
+	if (rows.empty() || rows.back() != '\n') {
+		writeData(outfile, "\n");
+	}
+}
+
+//Copies the rows of a file that cannot be mapped (such as a pipe or FIFO) to the output file, reading it as a stream
+void copyStreamedFile(int outfile, const string& filename, string& headerRow, bool& haveHeader)
+{
+	int infile = open(filename.c_str(), O_RDONLY | O_BINARY);
+	if (infile == -1) {
+		throw std::runtime_error("failed to read header row from file \"" + filename + "\"!");
+	}
+	
+	//Read until we have the entire header row
+	vector<char> buffer(BUFSIZE);
+	string start;
+	size_t headerEnd = string::npos;
+	int bytesRead = 0;
+	while (headerEnd == string::npos && (bytesRead = readData(infile, buffer.data(), (unsigned int)buffer.size())) > 0)
+	{
+		start.append(buffer.data(), bytesRead);
+		headerEnd = start.find('\n');
+	}
+	
+	if (bytesRead == -1 || start.empty())
+	{
+		close(infile);
 		throw std::runtime_error("failed to read header row from file \"" + filename + "\"!");
 	}
 	
-	return header;
+	string_view contents = start;
+	string_view header = contents.substr(0, headerEnd);
+	checkHeader(outfile, header, headerRow, haveHeader, filename);
+	
+	//Copy any rows that were read along with the header, followed by the remainder of the file
+	string_view rows = contents.substr(std::min(header.length() + 1, contents.length()));
+	writeData(outfile, rows);
+	char lastCharacter = (rows.empty()) ? 0 : rows.back();
+	while ((bytesRead = readData(infile, buffer.data(), (unsigned int)buffer.size())) > 0)
+	{
+		writeData(outfile, string_view(buffer.data(), bytesRead));
+		lastCharacter = buffer[bytesRead - 1];
+	}
+	
+	close(infile);
+	if (bytesRead == -1) {
+		throw std::runtime_error("failed to read the rows of file \"" + filename + "\"!");
+	}
+	
+	//If the input file didn't end with a trailing newline, append one ourselves
+	if (lastCharacter != '\n') {
+		writeData(outfile, "\n");
+	}
 }
 
 int main (int argc, char* argv[])
@@ -84,45 +185,26 @@ int main (int argc, char* argv[])
 			}
 			
 			//Attempt to open the output file
-			ofstream outfile(outfilePath.c_str(), ios::binary);
-			if (!outfile.is_open()) {
+			int outfile = open(outfilePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+			if (outfile == -1) {
 				throw std::runtime_error("failed to open output file!");
 			}
 			
-			//Read the header row of the first CSV file and write it to the output file
-			ifstream firstFile(files[0].c_str(), ios::binary);
-			string headerRow = extractHeader(firstFile, files[0]);
-			firstFile.close();
-			outfile << headerRow << "\n";
-			
-			//Iterate over each of the input CSV files
+			//Copy each of the input CSV files, using the header row of the first file and verifying that all of the others match it
+			//(regular files are mapped, while pipes and other files that cannot be mapped are read as streams, since they can only be read once)
+			string headerRow;
+			bool haveHeader = false;
 			for (vector<string>::iterator currFilePath = files.begin(); currFilePath != files.end(); ++currFilePath)
 			{
-				//Verify that the file's header row matches the one we're using
-				ifstream currFile(currFilePath->c_str(), ios::binary);
-				if (extractHeader(currFile, *currFilePath) != headerRow) {
-					throw std::runtime_error("the header for file \"" + *currFilePath + "\" does not match the header row of the first input file!");
+				if (file_info(*currFilePath).isRegular) {
+					copyMappedFile(outfile, *currFilePath, headerRow, haveHeader);
 				}
-				
-				//Copy the remaining rows to the output file
-				char buffer[BUFSIZE];
-				size_t bytesRead = 0;
-				bool hasTrailingNewline = false;
-				while ( (bytesRead = currFile.read(buffer, sizeof(buffer)).gcount()) != 0 )
-				{
-					hasTrailingNewline = (buffer[bytesRead - 1] == '\n');
-					outfile.write(buffer, bytesRead);
-				}
-				
-				//If the input file didn't end with a trailing newline, append one ourselves
-				if (hasTrailingNewline == false) {
-					outfile << "\n";
+				else {
+					copyStreamedFile(outfile, *currFilePath, headerRow, haveHeader);
 				}
-				
-				currFile.close();
 			}
 			
-			outfile.close();
+			close(outfile);
 		}
 		else {
 			clog << "Usage syntax:\ncat-csv OUTFILE <FILE/PATTERN> <FILE/PATTERN> ..." << endl;
@@ -33,8 +33,16 @@
 #include <fstream>
 #include <iomanip>
 #include <sstream>
+#include <fcntl.h>
 #include <simple-base/base.h>
 
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+	#define O_BINARY 0
+#endif
+
 using namespace std;
 
 int main (int argc, char *argv[])
@@ -53,42 +61,54 @@ int main (int argc, char *argv[])
 				infile.seekg(0, ios::beg);
 				
 				//Transform the filename into a constant variable style, e.g: "file.dat" becomes "FILE_DAT"
-				string filename = basename(string(argv[i]));
+				FilePath inpath(argv[i]);
+				string filename = string(inpath.basename());
 				filename =  str_replace(".", "_", filename);
 				filename =  str_replace("-", "_", filename);
 				filename = strip_chars(" '~!@#$%^&()+[]{}", filename);
 				filename = strtoupper(filename);
-				string outpath    = string(dirname(string(argv[i])) + strtolower(filename) + ".c");
-				string headerpath = string(dirname(string(argv[i])) + strtolower(filename) + ".h");
+				
+				//The output files are placed alongside the input file
+				FilePath outbase = FilePath(string(inpath.dirname())).append(strtolower(filename));
+				string outpath    = outbase.withExtension("c");
+				string headerpath = outbase.withExtension("h");
 				
 				//Open the output file, which will be the transformed filename with a .c extension (following the earlier example, "file.dat" becomes "file_dat.c")
-				ofstream outfile(outpath.c_str(), ios::binary);
-				if (outfile.is_open())
+				int outfile = open(outpath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+				if (outfile != -1)
 				{
+					//The generated code is written out one chunk at a time as it is built
+					StringBuilder output(outfile, BUFSIZE * 5);
+					
 					//Each file becomes a constant integer storing its length, and a character array holding all of the individual bytes
-					outfile << "const int SIZEOF_" << filename << " = " << length << ";" << endl;
-					outfile << "const unsigned char " << filename << "[" << length << "] = {\n";
+					output.append("const int SIZEOF_").append(filename).append(" = ").appendUInt(length).append(";\n");
+					output.append("const unsigned char ").append(filename).append("[").appendUInt(length).append("] = {\n");
 					
 					//Read the file one block at a time
 					char buffer[BUFSIZE];
 					size_t bytesRead = 0;
+					bool firstByte = true;
 					while ( (bytesRead = infile.read(buffer, sizeof(buffer)).gcount()) != 0 )
 					{
 						for (size_t i = 0; i < bytesRead; ++i)
 						{
 							//Output the hex value of each byte and seperate them with commas
-							outfile << byte_to_hex(buffer[i]) << ",";
+							if (!firstByte) {
+								output.append(',');
+							}
+							
+							output.appendHexByte(buffer[i], true);
+							firstByte = false;
 						}
 					}
 					
-					//Rewind to remove the last comma
-					unsigned int currPos = (int)outfile.tellp();
-					unsigned int newPos = currPos - 1;
-					outfile.seekp(newPos);
-					
 					//Finish the array (making sure we add a newline to keep certain versions of GCC happy), and close the output file
-					outfile << "\n};" << endl;
-					outfile.close();
+					output.append("\n};\n");
+					if (!output.flush()) {
+						clog << "Error: failed to write output file!" << endl;
+					}
+					
+					close(outfile);
 				}
 				else {
 					clog << "Error: failed to open output file!" << endl;
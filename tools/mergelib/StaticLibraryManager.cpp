@@ -123,17 +123,22 @@ bool StaticLibraryManager::ExtractLibToTempDirectory(const string& lib)
 		
 		//Name temporary object files using the SHA-1 sum of their contents, thereby consolidating any duplicate files
 		string fileChecksum = sha1(fileContents);
-		if (file_put_contents(this->tempDir + "/" + fileChecksum + ".o", fileContents) == false) {
+		if (std::find(seenObjectFiles.begin(), seenObjectFiles.end(), fileChecksum) != seenObjectFiles.end())
+		{
+			//Duplicates have identical contents, so there is no need to write them again
+			clog << "Note: consolidating duplicate object files with SHA-1 checksum " << fileChecksum << endl;
+			continue;
+		}
+		
+		//Preallocate the object file, since we know its full size up front
+		FileWriteOptions options;
+		options.preallocate = true;
+		if (file_put_contents(this->tempDir + "/" + fileChecksum + ".o", fileContents, options) == false) {
 			return false;
 		}
 		
 		//Keep track of the object files we have processed
-		if (std::find(seenObjectFiles.begin(), seenObjectFiles.end(), fileChecksum) != seenObjectFiles.end()) {
-			clog << "Note: consolidating duplicate object files with SHA-1 checksum " << fileChecksum << endl;
-		}
-		else {
-			seenObjectFiles.push_back(fileChecksum);
-		}
+		seenObjectFiles.push_back(fileChecksum);
 	}
 	
 	return true;
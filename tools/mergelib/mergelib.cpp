@@ -47,7 +47,6 @@ int main (int argc, char* argv[])
 {
 	if (argc > 2)
 	{
-		string tmpdir = generate_unique_filename();
 		string outlib = argv[1];
 		vector<string> libs(argv + 2, argv + argc);
 		
@@ -68,8 +67,15 @@ int main (int argc, char* argv[])
 			
 			try
 			{
+				//Create a private temporary directory for the extracted object files, which is removed once we are done with it
+				//(so that concurrent runs can never share a directory)
+				TempDirectory tmpdir("", "mergelib.");
+				if (!tmpdir.isOpen()) {
+					throw std::runtime_error("Failed to create a temporary directory");
+				}
+				
 				//Extract the object files from the input libraries using ar
-				StaticLibraryManager manager(tmpdir);
+				StaticLibraryManager manager(tmpdir.path());
 				for (vector<string>::iterator currLib = libs.begin(); currLib != libs.end(); ++currLib) {
 					manager.AddLibrary(*currLib);
 				}
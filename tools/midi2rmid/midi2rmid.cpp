@@ -28,26 +28,39 @@
 //  SOFTWARE.
 */
 #include <simple-base/base.h>
-#include <cstring>
 #include <stdint.h>
 #include <stdexcept>
 #include <iostream>
 #include <string>
+#include <fcntl.h>
+
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+	#define O_BINARY 0
+#endif
 
 //The size of the header for the RMID chunk itself
 #define RMID_CHUNK_HEADER_SIZE 12
 
+//The size of the RMID file header, including the header of the MIDI data chunk
+#define RMID_FILE_HEADER_SIZE 20
+
 using namespace std;
 
-void copyFileData(ifstream& infile, ofstream& outfile)
+void copyFileData(int infile, int outfile, uint32_t size, const string& filename)
 {
-	//Read the input file in chunks
-	char buffer[1024*1024];
-	size_t bytesRead = 0;
-	while ( (bytesRead = infile.read(buffer, sizeof(buffer)).gcount()) != 0 )
-	{
-		//Write the data to the output file
-		outfile.write(buffer, bytesRead);
+	//Append the entire input file to the output file, letting the kernel copy the data where possible
+	if (copy_range(infile, 0, outfile, -1, size) != size) {
+		throw std::runtime_error("failed to copy the contents of input file \"" + filename + "\"");
+	}
+}
+
+void flushOutput(BinaryWriter& writer)
+{
+	if (!writer.flush()) {
+		throw std::runtime_error("failed to write output file");
 	}
 }
 
@@ -63,50 +76,48 @@ int main (int argc, char* argv[])
 			string dlsFile  = ((argc > 2) ? argv[2] : replace_extension(midiFile, "dls"));
 			string rmidFile = ((argc > 3) ? argv[3] : replace_extension(midiFile, "rmi"));
 			
-			//Check that both of the input files exist
-			uint32_t midiSize = filesize(midiFile);
-			uint32_t dlsSize  = filesize(dlsFile);
-			if (midiSize == -1 || dlsSize == -1) {
+			//Open the input files and retrieve their sizes from the open descriptors
+			int midiFd = open(midiFile.c_str(), O_RDONLY | O_BINARY);
+			int dlsFd  = open(dlsFile.c_str(),  O_RDONLY | O_BINARY);
+			FileInfo midiInfo = file_info(midiFd);
+			FileInfo dlsInfo  = file_info(dlsFd);
+			if (!midiInfo.isRegular || !dlsInfo.isRegular) {
 				throw std::runtime_error("the input files \"" + midiFile + "\" and \"" + dlsFile + "\" could not be opened.");
 			}
 			
-			//The 20-byte RMID file header           Placeholder for RMID size                                   Placeholder for MIDI size
-			char rmidHeader[] = {'R', 'I', 'F', 'F', 0x0, 0x0, 0x0, 0x0, 'R', 'M', 'I', 'D', 'd', 'a', 't', 'a', 0x0, 0x0, 0x0, 0x0};
+			uint32_t midiSize = midiInfo.size;
+			uint32_t dlsSize  = dlsInfo.size;
 			
 			//If the MIDI filesize is odd, we need to append a padding byte to the end of the MIDI data
 			uint8_t midiPaddingSize = (((midiSize % 2) == 1) ? 1 : 0);
 			
-			//Fill the placeholder header fields with the length values
-			uint32_t rmidSize = RMID_CHUNK_HEADER_SIZE + midiSize + midiPaddingSize + dlsSize;
-			rmidSize = toLittleEndian(rmidSize);
-			midiSize = toLittleEndian(midiSize);
-			memcpy(rmidHeader + 4,  &rmidSize, sizeof(uint32_t));
-			memcpy(rmidHeader + 16, &midiSize, sizeof(uint32_t));
-			
-			//Open the input and output files
-			ifstream midiFileStream(midiFile.c_str(), ios::binary);
-			ifstream dlsFileStream (dlsFile.c_str(),  ios::binary);
-			ofstream rmidFileStream(rmidFile.c_str(), ios::binary);
+			//Open the output file
+			int rmidFd = open(rmidFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+			if (rmidFd == -1) {
+				throw std::runtime_error("failed to open output file \"" + rmidFile + "\"");
+			}
 			
-			//If any of the input or output files could not be opened, exit immediately
-			if (!midiFileStream.is_open()) { throw std::runtime_error("failed to open input file \"" + midiFile + "\""); }
-			if (!dlsFileStream.is_open())  { throw std::runtime_error("failed to open input file \"" + dlsFile  + "\""); }
-			if (!rmidFileStream.is_open()) { throw std::runtime_error("failed to open input file \"" + rmidFile + "\""); }
+			//Write the 20-byte RMID file header (the RIFF chunk header, the RMID form type, and the header of the MIDI data chunk)
+			BinaryWriter rmidWriter(rmidFd, RMID_FILE_HEADER_SIZE);
+			rmidWriter.write("RIFF");
+			rmidWriter.writeLE<uint32_t>(RMID_CHUNK_HEADER_SIZE + midiSize + midiPaddingSize + dlsSize);
+			rmidWriter.write("RMIDdata");
+			rmidWriter.writeLE<uint32_t>(midiSize);
+			flushOutput(rmidWriter);
 			
-			//Write the header, MIDI data, MIDI padding (if needed), and DLS data
-			rmidFileStream.write(rmidHeader, sizeof(rmidHeader));
-			copyFileData(midiFileStream, rmidFileStream);
+			//Write the MIDI data, MIDI padding (if needed), and DLS data
+			copyFileData(midiFd, rmidFd, midiSize, midiFile);
 			if (midiPaddingSize != 0)
 			{
-				const char pad = 0;
-				rmidFileStream.write(&pad, 1);
+				rmidWriter.writeLE<uint8_t>(0);
+				flushOutput(rmidWriter);
 			}
-			copyFileData(dlsFileStream,  rmidFileStream);
+			copyFileData(dlsFd, rmidFd, dlsSize, dlsFile);
 			
 			//Close the input and output files
-			midiFileStream.close();
-			dlsFileStream.close();
-			rmidFileStream.close();
+			close(midiFd);
+			close(dlsFd);
+			close(rmidFd);
 		}
 		catch (std::runtime_error& e) {
 			clog << "Error: " << e.what() << endl;
@@ -0,0 +1,127 @@
+/*
+//  Test Fixture Generator
+//  Copyright (c) 2016, Adam Rehn
+//  
+//  ---
+//  
+//  This utility creates test files of the specified size, either filled with
+//  random data (dense) or containing no data at all (sparse).
+//  
+//  Usage Syntax:    mkfixture [OPTIONS] SIZE FILE [FILE ...]
+//  
+//  The size may include a K, M, G or T suffix (powers of 1024).
+//  
+//  Options:
+//  
+//    --sparse      Create sparse files instead of filling them with random data
+//    --seed N      Seed the generator with N, so the same data can be reproduced
+//    --secure      Use the system's cryptographically-secure generator (slower)
+//    --direct      Bypass the page cache when writing
+//  
+//  When generating random data without a seed, the seed that was used is
+//  printed so that the files can be reproduced later. Files are generated in
+//  the order specified, from a single sequence of random data.
+//  
+//  ---
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+*/
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <memory>
+#include <vector>
+#include <string>
+#include <simple-base/base.h>
+
+using namespace std;
+
+int main (int argc, char* argv[])
+{
+	try
+	{
+		bool sparse   = false;
+		bool secure   = false;
+		bool directIO = false;
+		bool seeded   = false;
+		uint64_t seed = 0;
+		vector<string> positional;
+		
+		//Parse the supplied arguments
+		for (int i = 1; i < argc; ++i)
+		{
+			string currArg = argv[i];
+			if      (currArg == "--sparse") { sparse   = true; }
+			else if (currArg == "--secure") { secure   = true; }
+			else if (currArg == "--direct") { directIO = true; }
+			else if (currArg == "--seed" && i + 1 < argc)
+			{
+				//Reject anything other than a plain decimal number, since a mistyped seed would otherwise silently produce different data
+				string seedArg = argv[++i];
+				char* end = NULL;
+				errno = 0;
+				seed = strtoull(seedArg.c_str(), &end, 10);
+				if (seedArg.empty() || !isdigit((unsigned char)seedArg[0]) || *end != 0 || errno == ERANGE) {
+					throw std::runtime_error("invalid seed \"" + seedArg + "\"");
+				}
+				
+				seeded = true;
+			}
+			else {
+				positional.push_back(currArg);
+			}
+		}
+		
+		if (positional.size() < 2)
+		{
+			clog << "Usage syntax:\nmkfixture [--sparse] [--seed N] [--secure] [--direct] SIZE FILE [FILE ...]" << endl;
+			return 0;
+		}
+		
+		uint64_t size = parse_size(positional[0]);
+		
+		//Create the generator, reporting the seed if one wasn't supplied
+		unique_ptr<RandomDataGenerator> generator;
+		if (!sparse && !secure)
+		{
+			generator.reset((seeded) ? new RandomDataGenerator(seed) : new RandomDataGenerator());
+			if (!seeded) {
+				clog << "Seed: " << generator->seed() << endl;
+			}
+		}
+		
+		//Create each of the output files
+		for (vector<string>::iterator currFile = positional.begin() + 1; currFile != positional.end(); ++currFile)
+		{
+			bool success = (sparse) ? write_sparse_file(*currFile, size) : write_random_file(*currFile, size, generator.get(), directIO);
+			if (!success) {
+				throw std::runtime_error("failed to write output file \"" + *currFile + "\"");
+			}
+		}
+	}
+	catch (std::runtime_error& e)
+	{
+		clog << "Error: " << e.what() << endl;
+		return 1;
+	}
+	
+	return 0;
+}
@@ -0,0 +1,172 @@
+/*
+//  Process Spawning Benchmark
+//  Copyright (c) 2016, Adam Rehn
+//  
+//  ---
+//  
+//  This utility measures the number of child processes that can be spawned
+//  per second by executeProcessWithPipes(), and compares it against a simple
+//  fork() and execvp() baseline (under Unix-like platforms).
+//  
+//  Usage Syntax:    spawnbench [OPTIONS] [COMMAND]
+//  
+//  Sizes may include a K, M or G suffix (powers of 1024).
+//  
+//  Options:
+//  
+//    --count N     The number of processes to spawn (default 1000)
+//    --rss N       The amount of memory to allocate and touch before spawning
+//                  processes, to simulate a large parent process (default 0)
+//  
+//  The command defaults to "true". Since the cost of fork() grows with the
+//  size of the parent process, the difference between the two methods is
+//  most visible when a large value is specified for --rss.
+//  
+//  ---
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+*/
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <string>
+#include <simple-base/base.h>
+
+#ifndef _WIN32
+	#include <sys/types.h>
+	#include <sys/wait.h>
+	#include <unistd.h>
+#endif
+
+using namespace std;
+
+//Prints the results of a benchmark run
+void printResult(const string& method, unsigned int count, double seconds)
+{
+	printf("%-24s %12.0f %12.1f\n", method.c_str(), (double)count / seconds, (seconds * 1000000.0) / (double)count);
+}
+
+#ifndef _WIN32
+
+//Spawns the command using fork() and execvp(), waiting for it to complete
+void forkAndExec(const vector<string>& args)
+{
+	vector<char*> argv;
+	for (vector<string>::const_iterator arg = args.begin(); arg != args.end(); ++arg) {
+		argv.push_back((char*)arg->c_str());
+	}
+	
+	argv.push_back(NULL);
+	
+	pid_t childPid = fork();
+	if (childPid == -1) {
+		throw std::runtime_error("fork() failed");
+	}
+	
+	if (childPid == 0)
+	{
+		execvp(argv[0], argv.data());
+		_exit(-1);
+	}
+	
+	int status = 0;
+	waitpid(childPid, &status, 0);
+	if (!WIFEXITED(status) || WEXITSTATUS(status) == 255) {
+		throw std::runtime_error("failed to execute the command");
+	}
+}
+
+#endif
+
+int main (int argc, char* argv[])
+{
+	try
+	{
+		unsigned int count = 1000;
+		uint64_t rssSize = 0;
+		string command;
+		
+		//Parse the supplied arguments
+		for (int i = 1; i < argc; ++i)
+		{
+			string currArg = argv[i];
+			if      (currArg == "--count" && i + 1 < argc) { count   = (unsigned int)parse_size(argv[++i]); }
+			else if (currArg == "--rss"   && i + 1 < argc) { rssSize = parse_size(argv[++i]); }
+			else if (currArg == "--help")
+			{
+				clog << "Usage syntax:\nspawnbench [--count N] [--rss N] [COMMAND]" << endl;
+				return 0;
+			}
+			else {
+				command += (command.empty() ? "" : " ") + currArg;
+			}
+		}
+		
+		if (command.empty()) {
+			command = "true";
+		}
+		
+		if (count == 0) {
+			throw std::runtime_error("the count must be at least 1");
+		}
+		
+		//Allocate the requested amount of memory and touch every page, so that it is actually resident
+		vector<char> ballast(rssSize);
+		for (uint64_t offset = 0; offset < rssSize; offset += 4096) {
+			ballast[offset] = 1;
+		}
+		
+		printf("%-24s %12s %12s\n", "Method", "Spawns/s", "us/spawn");
+		
+		#ifndef _WIN32
+		
+		//Measure the fork() and execvp() baseline
+		vector<string> args = argv_from_string(command);
+		Stopwatch timer;
+		for (unsigned int i = 0; i < count; ++i) {
+			forkAndExec(args);
+		}
+		
+		printResult("fork+exec", count, (double)timer.elapsed() / 1000000000.0);
+		
+		#endif
+		
+		//Measure executeProcessWithPipes()
+		string stdOut;
+		string stdErr;
+		Stopwatch pipesTimer;
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			if (executeProcessWithPipes(command, "", stdOut, stdErr) == -1) {
+				throw std::runtime_error("failed to execute the command");
+			}
+		}
+		
+		printResult("executeProcessWithPipes", count, (double)pipesTimer.elapsed() / 1000000000.0);
+	}
+	catch (std::runtime_error& e)
+	{
+		clog << "Error: " << e.what() << endl;
+		return 1;
+	}
+	
+	return 0;
+}
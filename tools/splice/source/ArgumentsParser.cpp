@@ -25,43 +25,13 @@
 #include "OffsetParser.h"
 #include "StringUtil.h"
 
-#ifdef _WIN32
-	#include <direct.h>
-#endif
-
-#include <sys/stat.h>
+#include <simple-base/file_manipulation.h>
 #include <iostream>
 #include <stdexcept>
 #include <stdint.h>
 #include <string>
 using std::string;
 
-namespace
-{
-	//Determines the size in bytes of a file
-	off_t filesize (const string& path)
-	{
-		//Get the status of the file
-		struct stat fileInfo;
-		if (stat(path.c_str(), &fileInfo) == 0)
-		{
-			//File opened, check if it is a regular file
-			#if defined(_WIN32) && defined(_MSC_VER)
-			if (fileInfo.st_mode & _S_IFREG)
-			#else
-			if (S_ISREG(fileInfo.st_mode))
-			#endif
-			{
-				//Return the filesize in bytes
-				return fileInfo.st_size;
-			}
-		}
-		
-		//Could not determine the filesize
-		return -1;
-	}
-}
-
 void ArgumentsParser::parseArguments(int argc, char* argv[], string& outputFile, vector<FileSliceDetails>& filesAndSlices)
 {
 	OffsetParser<int64_t> parser;
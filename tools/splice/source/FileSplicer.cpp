@@ -23,11 +23,16 @@
 #include "FileSplicer.h"
 
 #include <stdexcept>
-#include <fstream>
-using std::istream;
+#include <fcntl.h>
+
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+	#define O_BINARY 0
+#endif
+
 using std::ostream;
-using std::ifstream;
-using std::ofstream;
 
 FileSliceDetails::FileSliceDetails(const string& filename, int64_t filesize)
 {
@@ -49,44 +54,26 @@ ostream& operator<<(ostream& o, const FileSliceDetails& details)
 	return o;
 }
 
-void FileSplicer::copySlice(istream& in, ostream& out, int64_t offsetStart, int64_t offsetEnd)
+void FileSplicer::copySlice(int in, int out, int64_t offsetStart, int64_t offsetEnd)
 {
-	//Seek to the starting offset
-	in.seekg(offsetStart);
-	
-	//Read the slice in multiple chunks, unless the slice size is smaller than our buffer size
-	char buffer[1024*1024];
-	uint64_t sliceSize = offsetEnd - offsetStart;
-	uint64_t chunkSize = std::min(sliceSize, (uint64_t)(sizeof(buffer)));
-	
-	//Copy the slice
-	size_t bytesCopied = 0;
-	while (bytesCopied < sliceSize)
-	{
-		//Attempt to read the data from the input file
-		size_t bytesRead = in.read(buffer, chunkSize).gcount();
-		if ((bytesRead == 0 || in.fail()) && !in.eof()) {
-			throw std::runtime_error("I/O error reading input file");
-		}
-		
-		//Write the data to the output file
-		out.write(buffer, bytesRead);
-		bytesCopied += bytesRead;
+	//Append the slice to the output file, letting the kernel copy the data where possible (slices are clipped to the end of the input file)
+	if (copy_range(in, offsetStart, out, -1, offsetEnd - offsetStart) == -1) {
+		throw std::runtime_error("I/O error writing output file");
 	}
 }
 
 void FileSplicer::splice(const string& outputFilename, const vector<FileSliceDetails>& slices)
 {
 	//Attempt to open the output file
-	ofstream outfile(outputFilename.c_str(), std::ios::binary);
-	if (outfile.is_open())
+	int outfile = open(outputFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+	if (outfile != -1)
 	{
 		//Iterate over each of the input files
 		for (auto currDetails : slices)
 		{
 			//Attempt to open the input file
-			ifstream infile(currDetails.filename.c_str(), std::ios::binary);
-			if (infile.is_open())
+			int infile = open(currDetails.filename.c_str(), O_RDONLY | O_BINARY);
+			if (infile != -1)
 			{
 				//Determine if offsets have been specified for the current input file
 				if (currDetails.slices.empty())
@@ -102,14 +89,14 @@ void FileSplicer::splice(const string& outputFilename, const vector<FileSliceDet
 					}
 				}
 				
-				infile.close();
+				close(infile);
 			}
 			else {
 				throw std::runtime_error("could not open input file \"" + currDetails.filename + "\"");
 			}
 		}
 		
-		outfile.close();
+		close(outfile);
 	}
 	else {
 		throw std::runtime_error("could not open output file \"" + outputFilename + "\"");
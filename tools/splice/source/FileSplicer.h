@@ -23,6 +23,7 @@
 #ifndef _SPLICE_FILE_SPLICER
 #define _SPLICE_FILE_SPLICER
 
+#include <simple-base/file_manipulation.h>
 #include <iostream>
 #include <stdint.h>
 #include <string>
@@ -54,7 +55,7 @@ class FileSplicer
 		static void splice(const string& outputFilename, const vector<FileSliceDetails>& slices);
 		
 	private:
-		static void copySlice(istream& in, ostream& out, int64_t offsetStart, int64_t offsetEnd);
+		static void copySlice(int in, int out, int64_t offsetStart, int64_t offsetEnd);
 };
 
 #endif
@@ -54,14 +54,17 @@ void InvokeForFile(const string& command, const string& file)
 	//Determine if $0 appears in the command
 	bool shouldAppendFilename = (!in("$0", command));
 	
+	//Parse the path components once, rather than once per token
+	FilePath path(file);
+	
 	//Expand any backreference-style tokens in the command
 	string expandedCommand = command;
-	expandedCommand = str_replace("$0", file,                            expandedCommand);
-	expandedCommand = str_replace("$1", basename(file),                  expandedCommand);
-	expandedCommand = str_replace("$2", strip_extension(file),           expandedCommand);
-	expandedCommand = str_replace("$3", strip_extension(basename(file)), expandedCommand);
-	expandedCommand = str_replace("$4", get_extension(basename(file)),   expandedCommand);
-	expandedCommand = str_replace("$5", dirname(file),                   expandedCommand);
+	expandedCommand = str_replace("$0", file,                          expandedCommand);
+	expandedCommand = str_replace("$1", string(path.basename()),       expandedCommand);
+	expandedCommand = str_replace("$2", string(path.stripExtension()), expandedCommand);
+	expandedCommand = str_replace("$3", string(path.stem()),           expandedCommand);
+	expandedCommand = str_replace("$4", string(path.extension()),      expandedCommand);
+	expandedCommand = str_replace("$5", string(path.dirname()),        expandedCommand);
 	
 	//If $0 did not appear in the command, append the filename to the end
 	if (shouldAppendFilename) {